@@ -0,0 +1,145 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ADAPTIVE_MUTEX_H_
+#define ATOMIC_ADAPTIVE_MUTEX_H_
+
+#include "atomic/atomic.h"
+#include "atomic/wait.h"
+
+namespace atomic {
+/// @brief A mutex that spins for a while before it puts the thread to sleep,
+/// where the spin duration is learned from how long recent waits took.
+///
+/// Each lock keeps a running estimate of how many spin iterations that a
+/// contended lock() needs before the lock becomes free (like the adaptive
+/// mutex of glibc). A waiter spins for up to twice the estimate (but at least
+/// MIN_SPINS and at most MAX_SPINS iterations) and then parks (using a futex
+/// on Linux). A wait that outlasts the spinning counts as zero spins, so
+/// short critical sections are waited for by spinning, and long critical
+/// sections quickly stop wasting CPU time on spinning.
+///
+/// The lock word follows the classic futex mutex design, where a lock with
+/// sleeping waiters is marked, so that an unlock() only makes a system call
+/// when there is someone to wake up.
+///
+/// @note This class requires C++11.
+class adaptive_mutex {
+public:
+  /// @brief The minimum number of spin iterations before parking.
+  static const int MIN_SPINS = 10;
+
+  /// @brief The maximum number of spin iterations before parking.
+  static const int MAX_SPINS = 200;
+
+  ATOMIC_CONSTEXPR adaptive_mutex()
+      : state_(UNLOCKED), scaled_spin_estimate_(0) {}
+
+  /// @brief Acquire the lock (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    int expected = UNLOCKED;
+    if (!state_.compare_exchange_strong(
+            expected, LOCKED, memory_order_acquire, memory_order_relaxed)) {
+      lock_slow();
+    }
+  }
+
+  /// @brief Try to acquire the lock (non-blocking).
+  /// @returns true if the lock was acquired.
+  bool try_lock() {
+    int expected = UNLOCKED;
+    return state_.load(memory_order_relaxed) == UNLOCKED &&
+           state_.compare_exchange_strong(
+               expected, LOCKED, memory_order_acquire, memory_order_relaxed);
+  }
+
+  /// @brief Release the lock.
+  /// @note It is an error to release a lock that has not been previously
+  /// acquired.
+  void unlock() {
+    if (state_.exchange(UNLOCKED, memory_order_release) == PARKED) {
+      detail::wake_by_address(state_, 1);
+    }
+  }
+
+  /// @returns the current spin budget (the maximum number of spin iterations
+  /// before a waiting thread is parked).
+  int spin_budget() const {
+    // Note: 2 * estimate = scaled estimate / 4.
+    const int budget = scaled_spin_estimate_.load(memory_order_relaxed) / 4;
+    if (budget < MIN_SPINS) {
+      return MIN_SPINS;
+    }
+    return budget < MAX_SPINS ? budget : MAX_SPINS;
+  }
+
+private:
+  static const int UNLOCKED = 0;
+  static const int LOCKED = 1;
+  static const int PARKED = 2;  // Locked, and there may be parked waiters.
+
+  void lock_slow() {
+    const int budget = spin_budget();
+    for (int spins = 1; spins <= budget; ++spins) {
+      detail::cpu_relax();
+      if (try_lock()) {
+        update_spin_estimate(spins);
+        return;
+      }
+    }
+
+    // Spinning did not pay off, so the spins were wasted. Count this as zero
+    // spins (rather than the full budget), so that the budget shrinks while
+    // the critical sections are too long for spinning.
+    update_spin_estimate(0);
+
+    // Park until the lock is free. The lock is marked as parked, so that the
+    // holder will wake us up (we can not know if there are other parked
+    // waiters, so we must keep the mark when we get the lock).
+    while (state_.exchange(PARKED, memory_order_acquire) != UNLOCKED) {
+      detail::wait_on_address(state_, PARKED);
+    }
+  }
+
+  // An exponential moving average of the number of spins (with weight 1/8
+  // for the new sample). The estimate is kept in fixed point (scaled by 8),
+  // so that it also converges when the samples are close to the estimate.
+  // The estimate is only a hint, so relaxed accesses are enough (a lost
+  // update is harmless).
+  void update_spin_estimate(const int spins) {
+    const int scaled = scaled_spin_estimate_.load(memory_order_relaxed);
+    scaled_spin_estimate_.store(scaled + spins - scaled / 8,
+                                memory_order_relaxed);
+  }
+
+  atomic<int> state_;
+  atomic<int> scaled_spin_estimate_;  // The spin estimate * 8.
+
+  ATOMIC_DISALLOW_COPY(adaptive_mutex)
+};
+}  // namespace atomic
+
+#endif  // ATOMIC_ADAPTIVE_MUTEX_H_
@@ -0,0 +1,199 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ASYMMETRIC_FENCE_H_
+#define ATOMIC_ASYMMETRIC_FENCE_H_
+
+#include "atomic/atomic.h"
+#include "atomic/spinlock.h"
+
+// Select the mechanism for the heavy fence. When there is none, both fences
+// are plain sequentially consistent thread fences.
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define ATOMIC_ASYMMETRIC_FENCE_USE_LINUX
+// The mprotect() fallback only works where TLB shootdowns use IPIs.
+#if defined(__i386__) || defined(__x86_64__)
+#define ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT
+#endif
+#elif defined(_WIN32)
+extern "C" __declspec(dllimport) void __stdcall FlushProcessWriteBuffers(void);
+#define ATOMIC_ASYMMETRIC_FENCE_USE_WIN32
+#endif
+
+namespace atomic {
+namespace detail {
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_LINUX)
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT)
+// A page that is used by mprotect_fence().
+struct mprotect_fence_page {
+  mprotect_fence_page() : ptr(0) {
+    void* p =
+        mmap(0, 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED) {
+      ptr = static_cast<char*>(p);
+    }
+  }
+
+  static mprotect_fence_page& instance() {
+    static mprotect_fence_page s_page;
+    return s_page;
+  }
+
+  char* ptr;
+  spinlock lock;  // Serializes the protection changes.
+};
+
+/// @brief Issue a heavy fence by changing the protection of a page.
+///
+/// Write protecting a page that has been written to forces the kernel to
+/// flush the TLB entries of the page on all CPUs that currently run threads
+/// of the process, which is done with inter-processor interrupts (IPIs) that
+/// act as full memory barriers on those CPUs.
+///
+/// @note This relies on the kernel using IPIs for TLB shootdowns, which is
+/// the case on x86, but not on architectures that broadcast TLB invalidations
+/// in hardware (e.g. AArch64), so it is only used on x86.
+/// @pre mprotect_fence_page::instance().ptr is not null.
+inline void mprotect_fence() {
+  mprotect_fence_page& page = mprotect_fence_page::instance();
+  lock_guard guard(page.lock);
+  mprotect(page.ptr, 1, PROT_READ | PROT_WRITE);
+  // Touch the page, so that this CPU has a TLB entry that must be flushed.
+  *static_cast<volatile char*>(page.ptr) = 0;
+  mprotect(page.ptr, 1, PROT_READ);
+}
+#endif  // ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT
+
+/// @returns true if the membarrier() system call supports private expedited
+/// barriers (and the process has registered for them).
+inline bool has_membarrier() {
+#if defined(SYS_membarrier)
+  // The commands of membarrier() (see linux/membarrier.h).
+  const int CMD_QUERY = 0;
+  const int CMD_PRIVATE_EXPEDITED = 1 << 3;
+  const int CMD_REGISTER_PRIVATE_EXPEDITED = 1 << 4;
+
+  struct registration {
+    registration() : ok(false) {
+      const long cmds = syscall(SYS_membarrier, CMD_QUERY, 0);
+      ok = cmds > 0 && (cmds & CMD_PRIVATE_EXPEDITED) != 0 &&
+           syscall(SYS_membarrier, CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    }
+    bool ok;
+  };
+  static const registration s_registration;
+  return s_registration.ok;
+#else
+  return false;
+#endif
+}
+
+/// @returns true if the system has a heavy fence, in which case the light
+/// fence does not need to emit any instructions.
+inline bool has_heavy_fence() {
+  struct availability {
+    availability() : ok(has_membarrier()) {
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT)
+      ok = ok || mprotect_fence_page::instance().ptr != 0;
+#endif
+    }
+    bool ok;
+  };
+  static const availability s_availability;
+  return s_availability.ok;
+}
+#endif  // ATOMIC_ASYMMETRIC_FENCE_USE_LINUX
+}  // namespace detail
+
+/// @brief Issue the light side of an asymmetric fence.
+///
+/// An asymmetric fence is a pair of fences where one side is cheap and the
+/// other side is expensive. Together they act like a pair of sequentially
+/// consistent thread fences, i.e. a light fence and a heavy fence in
+/// different threads order the accesses around them just like two
+/// thread_fence(memory_order_seq_cst) would. This is useful when one side
+/// (e.g. the read side of a lock) runs much more often than the other side.
+///
+/// The light fence is only a compiler fence (no instructions are emitted)
+/// when the system supports a heavy fence, and otherwise it is a sequentially
+/// consistent thread fence.
+///
+/// @note A light fence is only ordered with respect to heavy fences, not with
+/// respect to other light fences.
+inline void asymmetric_thread_fence_light() {
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_LINUX)
+  if (detail::has_heavy_fence()) {
+    signal_fence(memory_order_seq_cst);
+  } else {
+    thread_fence(memory_order_seq_cst);
+  }
+#elif defined(ATOMIC_ASYMMETRIC_FENCE_USE_WIN32)
+  signal_fence(memory_order_seq_cst);
+#else
+  thread_fence(memory_order_seq_cst);
+#endif
+}
+
+/// @brief Issue the heavy side of an asymmetric fence.
+///
+/// The heavy fence forces a full memory barrier on all CPUs that are running
+/// threads of the calling process. On Linux this uses the membarrier() system
+/// call (with a fallback that changes the protection of a page on x86), and on
+/// Windows it uses FlushProcessWriteBuffers(). Either way it is expensive
+/// (several microseconds or more), and should only be used on rare paths.
+/// When none of these are available, both fences are sequentially consistent
+/// thread fences.
+///
+/// @see asymmetric_thread_fence_light
+inline void asymmetric_thread_fence_heavy() {
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_LINUX)
+#if defined(SYS_membarrier)
+  // Note: 1 << 3 = MEMBARRIER_CMD_PRIVATE_EXPEDITED.
+  if (detail::has_membarrier() && syscall(SYS_membarrier, 1 << 3, 0) == 0) {
+    return;
+  }
+#endif
+#if defined(ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT)
+  if (detail::mprotect_fence_page::instance().ptr != 0) {
+    detail::mprotect_fence();
+    return;
+  }
+#endif
+  thread_fence(memory_order_seq_cst);
+#elif defined(ATOMIC_ASYMMETRIC_FENCE_USE_WIN32)
+  FlushProcessWriteBuffers();
+#else
+  thread_fence(memory_order_seq_cst);
+#endif
+}
+}  // namespace atomic
+
+#undef ATOMIC_ASYMMETRIC_FENCE_USE_LINUX
+#undef ATOMIC_ASYMMETRIC_FENCE_USE_MPROTECT
+#undef ATOMIC_ASYMMETRIC_FENCE_USE_WIN32
+
+#endif  // ATOMIC_ASYMMETRIC_FENCE_H_
@@ -56,52 +56,414 @@
       line)[(2 * static_cast<int>(!!(condition))) - 1] _impl_UNUSED
 #endif
 
+// constexpr constructors make it possible to constant-initialize global
+// objects (so that they do not depend on the order of dynamic initialization).
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define ATOMIC_CONSTEXPR constexpr
+#else
+#define ATOMIC_CONSTEXPR
+#endif
+
+// The assumed size of a cache line (used for padding shared data in order to
+// avoid false sharing).
+#ifndef ATOMIC_CACHE_LINE_SIZE
+#define ATOMIC_CACHE_LINE_SIZE 64
+#endif
+
+// Select the implementation. ATOMIC_HAS_DWCAS is defined when atomic<T>
+// supports 16-byte types, and ATOMIC_HAS_ATOMIC_REF is defined when
+// atomic_ref<T> (see atomic_ref.h) is supported.
 #if defined(__GNUC__) || defined(__clang__) || defined(__xlc__)
 #define ATOMIC_USE_GCC_INTRINSICS
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16) && defined(__SIZEOF_INT128__)
+#define ATOMIC_HAS_DWCAS
+#endif
+#include "atomic_gcc.h"
+#define ATOMIC_HAS_ATOMIC_REF
+#if defined(__aarch64__) && !defined(ATOMIC_NO_LSE_DISPATCH) && \
+    (defined(__ARM_FEATURE_ATOMICS) || defined(__linux__))
+#define ATOMIC_USE_AARCH64_LSE
+#include "atomic_aarch64.h"
+#endif
 #elif defined(_MSC_VER)
 #define ATOMIC_USE_MSVC_INTRINSICS
 #include "atomic_msvc.h"
+#include <cstring>
+#define ATOMIC_HAS_ATOMIC_REF
 #elif __cplusplus >= 201103L
 #define ATOMIC_USE_CPP11_ATOMIC
 #include <atomic>
+#include <cstring>
+#if __cplusplus >= 202002L
+#define ATOMIC_HAS_ATOMIC_REF
+#endif
 #else
 #error Unsupported compiler / system.
 #endif
 
 namespace atomic {
+/// @brief Memory ordering constraints for atomic operations.
+///
+/// The semantics are the same as for the corresponding C++11 std::memory_order
+/// values. Note that an implementation may use a stronger ordering than the
+/// requested one (e.g. MSVC always uses sequentially consistent ordering for
+/// read-modify-write operations).
+enum memory_order {
+  memory_order_relaxed,
+  memory_order_consume,
+  memory_order_acquire,
+  memory_order_release,
+  memory_order_acq_rel,
+  memory_order_seq_cst
+};
+
+namespace detail {
+struct true_type {
+  static const bool value = true;
+};
+
+struct false_type {
+  static const bool value = false;
+};
+
+template <typename T>
+struct is_floating_point : false_type {};
+template <>
+struct is_floating_point<float> : true_type {};
+template <>
+struct is_floating_point<double> : true_type {};
+template <>
+struct is_floating_point<long double> : true_type {};
+
 template <typename T>
-class atomic {
+struct is_integral : false_type {};
+template <>
+struct is_integral<bool> : true_type {};
+template <>
+struct is_integral<char> : true_type {};
+template <>
+struct is_integral<signed char> : true_type {};
+template <>
+struct is_integral<unsigned char> : true_type {};
+#if !defined(_MSC_VER) || defined(_NATIVE_WCHAR_T_DEFINED)
+template <>
+struct is_integral<wchar_t> : true_type {};
+#endif
+template <>
+struct is_integral<short> : true_type {};
+template <>
+struct is_integral<unsigned short> : true_type {};
+template <>
+struct is_integral<int> : true_type {};
+template <>
+struct is_integral<unsigned int> : true_type {};
+template <>
+struct is_integral<long> : true_type {};
+template <>
+struct is_integral<unsigned long> : true_type {};
+#if __cplusplus >= 201103L || defined(_MSC_VER)
+template <>
+struct is_integral<long long> : true_type {};
+template <>
+struct is_integral<unsigned long long> : true_type {};
+#endif
+
+template <typename T>
+struct is_pointer : false_type {};
+template <typename T>
+struct is_pointer<T*> : true_type {};
+
+template <bool B>
+struct bool_constant : false_type {};
+template <>
+struct bool_constant<true> : true_type {};
+
+/// @note Only valid for arithmetic types.
+template <typename T>
+struct is_signed {
+  static const bool value = static_cast<T>(-1) < static_cast<T>(0);
+};
+
+/// @brief The unsigned integer type that is used for representing the bits of
+/// an atomic object of size N.
+template <unsigned N>
+struct uint_of_size {};
+template <>
+struct uint_of_size<1> {
+  typedef unsigned char type;
+};
+template <>
+struct uint_of_size<2> {
+  typedef unsigned short type;
+};
+template <>
+struct uint_of_size<4> {
+  typedef unsigned int type;
+};
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+template <>
+struct uint_of_size<8> {
+#if __SIZEOF_LONG__ == 8
+  typedef unsigned long type;
+#else
+  __extension__ typedef unsigned long long type;
+#endif
+};
+#if defined(ATOMIC_HAS_DWCAS)
+template <>
+struct uint_of_size<16> {
+  __extension__ typedef unsigned __int128 type;
+};
+#endif
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+template <>
+struct uint_of_size<8> {
+  typedef unsigned __int64 type;
+};
+#endif
+
+/// @brief Reinterpret the bits of a value as another type of the same size.
+///
+/// memcpy is the only portable way of doing this without invoking undefined
+/// behavior (compilers reduce it to a register move).
+template <typename To, typename From>
+struct bit_caster {
+  static To cast(const From& from) {
+    To to;
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    __builtin_memcpy(&to, &from, sizeof(To));
+#else
+    std::memcpy(&to, &from, sizeof(To));
+#endif
+    return to;
+  }
+};
+
+template <typename T>
+struct bit_caster<T, T> {
+  static ATOMIC_CONSTEXPR T cast(const T& from) {
+    return from;
+  }
+};
+
+/// @returns a memory order that is valid for a load operation, and that is at
+/// least as strong as the load part of @c order.
+inline memory_order load_order(const memory_order order) {
+  if (order == memory_order_release) {
+    return memory_order_relaxed;
+  }
+  if (order == memory_order_acq_rel) {
+    return memory_order_acquire;
+  }
+  return order;
+}
+
+#if defined(ATOMIC_USE_CPP11_ATOMIC)
+inline std::memory_order to_std_memory_order(const memory_order order) {
+  switch (order) {
+    case memory_order_relaxed:
+      return std::memory_order_relaxed;
+    case memory_order_consume:
+      return std::memory_order_consume;
+    case memory_order_acquire:
+      return std::memory_order_acquire;
+    case memory_order_release:
+      return std::memory_order_release;
+    case memory_order_acq_rel:
+      return std::memory_order_acq_rel;
+    default:
+      return std::memory_order_seq_cst;
+  }
+}
+#endif
+}  // namespace detail
+
+/// @brief An atomic boolean flag.
+///
+/// This is the simplest atomic type, and it maps to the cheapest atomic
+/// instructions of the target architecture (e.g. a byte exchange). It only
+/// occupies a single byte.
+class atomic_flag {
 public:
-  ATOMIC_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
-                           sizeof(T) == 8,
-                       "Only types of size 1, 2, 4 or 8 are supported");
+  /// @brief Construct a flag in the clear state.
+  ATOMIC_CONSTEXPR atomic_flag() : value_(0) {}
 
-  atomic() : value_(static_cast<T>(0)) {}
+  /// @brief Atomically set the flag.
+  /// @param order The memory ordering constraint.
+  /// @returns true if the flag was already set.
+  bool test_and_set(const memory_order order = memory_order_seq_cst) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return __atomic_test_and_set(&value_, order);
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    (void)order;
+    return msvc::interlocked<char>::exchange(&value_, 1) != 0;
+#else
+    return value_.exchange(1, detail::to_std_memory_order(order)) != 0;
+#endif
+  }
 
-  explicit atomic(const T value) : value_(value) {}
+  /// @brief Atomically clear the flag.
+  /// @param order The memory ordering constraint.
+  void clear(const memory_order order = memory_order_seq_cst) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    __atomic_clear(&value_, order);
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    (void)order;
+    (void)msvc::interlocked<char>::exchange(&value_, 0);
+#else
+    value_.store(0, detail::to_std_memory_order(order));
+#endif
+  }
 
-  /// @brief Performs an atomic increment operation (value + 1).
-  /// @returns The new value of the atomic object.
-  T operator++() {
+  /// @param order The memory ordering constraint.
+  /// @returns true if the flag is set.
+  bool test(const memory_order order = memory_order_seq_cst) const {
 #if defined(ATOMIC_USE_GCC_INTRINSICS)
-    return __atomic_add_fetch(&value_, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&value_, order) != 0;
 #elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    return msvc::interlocked<T>::increment(&value_);
+    (void)order;
+    return value_ != 0;
 #else
-    return ++value_;
+    return value_.load(detail::to_std_memory_order(order)) != 0;
 #endif
   }
 
-  /// @brief Performs an atomic decrement operation (value - 1).
-  /// @returns The new value of the atomic object.
-  T operator--() {
+private:
+#if defined(ATOMIC_USE_GCC_INTRINSICS) || defined(ATOMIC_USE_MSVC_INTRINSICS)
+  volatile char value_;
+#else
+  std::atomic<char> value_;
+#endif
+
+  ATOMIC_DISALLOW_COPY(atomic_flag)
+};
+
+/// @brief Issue a memory fence (a synchronization point between threads).
+///
+/// This corresponds to std::atomic_thread_fence(). A fence makes it possible
+/// to use relaxed operations for a batch of accesses, with a single fence to
+/// order the batch relative to other accesses.
+///
+/// @param order The memory ordering constraint.
+inline void thread_fence(const memory_order order) {
 #if defined(ATOMIC_USE_GCC_INTRINSICS)
-    return __atomic_sub_fetch(&value_, 1, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(order);
 #elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    return msvc::interlocked<T>::decrement(&value_);
+  if (order == memory_order_seq_cst) {
+    msvc::full_fence();
+  } else if (order != memory_order_relaxed) {
+    msvc::acq_rel_fence();
+  }
+#else
+  std::atomic_thread_fence(detail::to_std_memory_order(order));
+#endif
+}
+
+/// @brief Issue a compiler-only fence (a synchronization point between a
+/// thread and a signal handler executed in the same thread).
+///
+/// This corresponds to std::atomic_signal_fence(). No CPU instructions are
+/// emitted, but the compiler will not reorder memory accesses across the fence
+/// (as dictated by @c order).
+///
+/// @param order The memory ordering constraint.
+inline void signal_fence(const memory_order order) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+  __atomic_signal_fence(order);
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+  if (order != memory_order_relaxed) {
+    _ReadWriteBarrier();
+  }
+#else
+  std::atomic_signal_fence(detail::to_std_memory_order(order));
+#endif
+}
+
+namespace detail {
+/// @brief The operations of atomic<T> and atomic_ref<T>.
+///
+/// Derived must provide storage(), which returns a pointer to the (volatile)
+/// storage of the value, or the std::atomic / std::atomic_ref object when
+/// std::atomic is used as a fallback.
+///
+/// Note that the operations are not tied to how the value is stored, so they
+/// can also be applied to existing objects (see atomic_ref.h).
+template <typename T, typename Derived>
+class atomic_base {
+public:
+#if defined(ATOMIC_HAS_DWCAS)
+  ATOMIC_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                           sizeof(T) == 8 || sizeof(T) == 16,
+                       "Only types of size 1, 2, 4, 8 or 16 are supported");
 #else
-    return --value_;
+  ATOMIC_STATIC_ASSERT(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                           sizeof(T) == 8,
+                       "Only types of size 1, 2, 4 or 8 are supported");
 #endif
+
+  /// @brief Performs an atomic increment operation (value + 1).
+  /// @returns The new value of the atomic object.
+  T operator++() {
+    return static_cast<T>(fetch_add(static_cast<T>(1)) + static_cast<T>(1));
+  }
+
+  /// @brief Performs an atomic decrement operation (value - 1).
+  /// @returns The new value of the atomic object.
+  T operator--() {
+    return static_cast<T>(fetch_sub(static_cast<T>(1)) - static_cast<T>(1));
+  }
+
+  /// @brief Performs an atomic addition operation (value + x).
+  /// @param x The value to add to the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  /// @note For floating point types this is a CAS loop.
+  T fetch_add(const T x, const memory_order order = memory_order_seq_cst) {
+    return fetch_add(x, order, detail::is_floating_point<T>());
+  }
+
+  /// @brief Performs an atomic subtraction operation (value - x).
+  /// @param x The value to subtract from the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  /// @note For floating point types this is a CAS loop.
+  T fetch_sub(const T x, const memory_order order = memory_order_seq_cst) {
+    return fetch_sub(x, order, detail::is_floating_point<T>());
+  }
+
+  /// @brief Performs an atomic maximum operation (max(value, x)).
+  ///
+  /// The atomic object is only written to if @c x is greater than the current
+  /// value (as given by operator<), so updating a high-water mark that rarely
+  /// changes is usually a read-only operation. When the value needs to be
+  /// updated, integer types use native max instructions where available
+  /// (ARMv8.1 LSE), and other types use a CAS loop.
+  ///
+  /// @param x The value to compare with the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  T fetch_max(const T x, const memory_order order = memory_order_seq_cst) {
+    const storage_type old_val = load_storage(detail::load_order(order));
+    if (!(from_storage(old_val) < x)) {
+      return from_storage(old_val);
+    }
+    return fetch_max(old_val, x, order, detail::is_integral<T>());
+  }
+
+  /// @brief Performs an atomic minimum operation (min(value, x)).
+  ///
+  /// The atomic object is only written to if @c x is less than the current
+  /// value (as given by operator<). See fetch_max().
+  ///
+  /// @param x The value to compare with the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  T fetch_min(const T x, const memory_order order = memory_order_seq_cst) {
+    const storage_type old_val = load_storage(detail::load_order(order));
+    if (!(x < from_storage(old_val))) {
+      return from_storage(old_val);
+    }
+    return fetch_min(old_val, x, order, detail::is_integral<T>());
   }
 
   /// @brief Performs an atomic compare-and-swap (CAS) operation.
@@ -112,18 +474,108 @@ public:
   /// @param expected_val The expected value of the atomic object.
   /// @param new_val The new value to write to the atomic object.
   /// @returns True if new_value was written to the atomic object.
+  /// @note The values are compared bitwise (not with operator==).
+  /// @note This is a weak CAS (it may fail spuriously). Prefer
+  /// compare_exchange_weak() in loops, since it returns the observed value.
   bool compare_exchange(const T expected_val, const T new_val) {
-#if defined(ATOMIC_USE_GCC_INTRINSICS)
     T e = expected_val;
-    return __atomic_compare_exchange_n(
-        &value_, &e, new_val, true, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return compare_exchange_weak(e, new_val);
+  }
+
+  /// @brief Performs an atomic compare-and-swap (CAS) operation that may fail
+  /// spuriously.
+  ///
+  /// The value of the atomic object is only updated to @c desired if the
+  /// current value of the atomic object matches @c expected. On failure,
+  /// @c expected is updated with the observed value, so a CAS loop does not
+  /// need to reload the atomic object. The operation may fail even if the
+  /// values match (e.g. with LL/SC instructions), so it should be used in a
+  /// loop.
+  ///
+  /// @param[in,out] expected The expected value of the atomic object.
+  /// @param desired The new value to write to the atomic object.
+  /// @param success The memory ordering constraint if the CAS succeeds.
+  /// @param failure The memory ordering constraint if the CAS fails (must not
+  /// be memory_order_release or memory_order_acq_rel).
+  /// @returns True if @c desired was written to the atomic object.
+  /// @note The values are compared bitwise (not with operator==).
+  bool compare_exchange_weak(T& expected,
+                             const T desired,
+                             const memory_order success,
+                             const memory_order failure) {
+    return compare_exchange_value(expected, desired, true, success, failure);
+  }
+
+  /// @brief Performs a weak compare-and-swap operation.
+  ///
+  /// The memory order of a failed CAS is derived from @c order (the load part
+  /// of the order).
+  bool compare_exchange_weak(T& expected,
+                             const T desired,
+                             const memory_order order = memory_order_seq_cst) {
+    return compare_exchange_value(
+        expected, desired, true, order, detail::load_order(order));
+  }
+
+  /// @brief Performs an atomic compare-and-swap (CAS) operation.
+  ///
+  /// Same as compare_exchange_weak(), except that the operation only fails if
+  /// the current value of the atomic object does not match @c expected.
+  ///
+  /// @param[in,out] expected The expected value of the atomic object.
+  /// @param desired The new value to write to the atomic object.
+  /// @param success The memory ordering constraint if the CAS succeeds.
+  /// @param failure The memory ordering constraint if the CAS fails (must not
+  /// be memory_order_release or memory_order_acq_rel).
+  /// @returns True if @c desired was written to the atomic object.
+  bool compare_exchange_strong(T& expected,
+                               const T desired,
+                               const memory_order success,
+                               const memory_order failure) {
+    return compare_exchange_value(expected, desired, false, success, failure);
+  }
+
+  /// @brief Performs a strong compare-and-swap operation.
+  ///
+  /// The memory order of a failed CAS is derived from @c order (the load part
+  /// of the order).
+  bool compare_exchange_strong(
+      T& expected,
+      const T desired,
+      const memory_order order = memory_order_seq_cst) {
+    return compare_exchange_value(
+        expected, desired, false, order, detail::load_order(order));
+  }
+
+  /// @brief Performs an atomic bitwise OR operation (value | x).
+  /// @param x The value to OR with the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  T fetch_or(const T x, const memory_order order = memory_order_seq_cst) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return from_storage(
+        ops::fetch_or(derived().storage(), to_storage(x), order));
 #elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    const T old_val =
-        msvc::interlocked<T>::compare_exchange(&value_, new_val, expected_val);
-    return (old_val == expected_val);
+    (void)order;
+    return from_storage(ops::fetch_or(derived().storage(), to_storage(x)));
 #else
-    T e = expected_val;
-    return value_.compare_exchange_weak(e, new_val);
+    return derived().storage().fetch_or(x, detail::to_std_memory_order(order));
+#endif
+  }
+
+  /// @brief Performs an atomic bitwise AND operation (value & x).
+  /// @param x The value to AND with the atomic object.
+  /// @param order The memory ordering constraint.
+  /// @returns The old value of the atomic object.
+  T fetch_and(const T x, const memory_order order = memory_order_seq_cst) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return from_storage(
+        ops::fetch_and(derived().storage(), to_storage(x), order));
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    (void)order;
+    return from_storage(ops::fetch_and(derived().storage(), to_storage(x)));
+#else
+    return derived().storage().fetch_and(x, detail::to_std_memory_order(order));
 #endif
   }
 
@@ -133,28 +585,25 @@ public:
   /// value.
   ///
   /// @param new_val The new value to write to the atomic object.
-  void store(const T new_val) {
+  /// @param order The memory ordering constraint.
+  void store(const T new_val,
+             const memory_order order = memory_order_seq_cst) {
 #if defined(ATOMIC_USE_GCC_INTRINSICS)
-    __atomic_store_n(&value_, new_val, __ATOMIC_SEQ_CST);
+    ops::store(derived().storage(), to_storage(new_val), order);
 #elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    (void)msvc::interlocked<T>::exchange(&value_, new_val);
+    (void)order;
+    (void)ops::exchange(derived().storage(), to_storage(new_val));
 #else
-    value_.store(new_val);
+    derived().storage().store(new_val, detail::to_std_memory_order(order));
 #endif
   }
 
+  /// @param order The memory ordering constraint.
   /// @returns the current value of the atomic object.
   /// @note Be careful about how this is used, since any operations on the
   /// returned value are inherently non-atomic.
-  T load() const {
-#if defined(ATOMIC_USE_GCC_INTRINSICS)
-    return __atomic_load_n(&value_, __ATOMIC_SEQ_CST);
-#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    // TODO(m): Is there a better solution for MSVC?
-    return value_;
-#else
-    return value_;
-#endif
+  T load(const memory_order order = memory_order_seq_cst) const {
+    return from_storage(load_storage(order));
   }
 
   /// @brief Performs an atomic exchange operation.
@@ -163,29 +612,336 @@ public:
   /// value, and the old value is returned.
   ///
   /// @param new_val The new value to write to the atomic object.
+  /// @param order The memory ordering constraint.
   /// @returns the old value.
-  T exchange(const T new_val) {
+  T exchange(const T new_val,
+             const memory_order order = memory_order_seq_cst) {
 #if defined(ATOMIC_USE_GCC_INTRINSICS)
-    return __atomic_exchange_n(&value_, new_val, __ATOMIC_SEQ_CST);
+    return from_storage(
+        ops::exchange(derived().storage(), to_storage(new_val), order));
 #elif defined(ATOMIC_USE_MSVC_INTRINSICS)
-    return msvc::interlocked<T>::exchange(&value_, new_val);
+    (void)order;
+    return from_storage(
+        ops::exchange(derived().storage(), to_storage(new_val)));
 #else
-    return value_.exchange(new_val);
+    return derived().storage().exchange(
+        new_val, detail::to_std_memory_order(order));
 #endif
   }
 
-  T operator=(const T new_value) {
-    store(new_value);
-    return new_value;
-  }
-
   operator T() const {
     return load();
   }
 
+protected:
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+  typedef typename detail::uint_of_size<sizeof(T)>::type storage_type;
+#if defined(ATOMIC_USE_AARCH64_LSE)
+  typedef aarch64::ops<storage_type> ops;
+#else
+  typedef gcc::ops<storage_type> ops;
+#endif
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+  typedef typename detail::uint_of_size<sizeof(T)>::type storage_type;
+  typedef msvc::interlocked<storage_type> ops;
+#else
+  typedef T storage_type;
+#endif
+
+  static ATOMIC_CONSTEXPR storage_type to_storage(const T x) {
+    return detail::bit_caster<storage_type, T>::cast(x);
+  }
+
+  static T from_storage(const storage_type x) {
+    return detail::bit_caster<T, storage_type>::cast(x);
+  }
+
+  // Like to_storage(), but usable in constant expressions when T is an
+  // integral type (or when the storage type is T itself).
+  static ATOMIC_CONSTEXPR storage_type init_storage(const T x) {
+    return init_storage(x, detail::is_integral<T>());
+  }
+
+  // The storage of a value-initialized T. For arithmetic and pointer types
+  // this is all zero bits, which can be used in constant expressions.
+  static ATOMIC_CONSTEXPR storage_type default_storage() {
+    return default_storage(
+        detail::bool_constant<detail::is_integral<T>::value ||
+                              detail::is_floating_point<T>::value ||
+                              detail::is_pointer<T>::value>());
+  }
+
+  ATOMIC_CONSTEXPR atomic_base() {}
+
+#if defined(ATOMIC_USE_GCC_INTRINSICS) || defined(ATOMIC_USE_MSVC_INTRINSICS)
+  typedef volatile storage_type* storage_ref;
+
+  // Access an existing object of type T as atomic storage.
+  static storage_ref storage_of(T* ptr) {
+    return reinterpret_cast<storage_ref>(ptr);
+  }
+#elif defined(ATOMIC_HAS_ATOMIC_REF)
+  typedef std::atomic_ref<T> storage_ref;
+
+  // Access an existing object of type T as atomic storage.
+  static storage_ref storage_of(T* ptr) {
+    return std::atomic_ref<T>(*ptr);
+  }
+#endif
+
+private:
+  Derived& derived() {
+    return static_cast<Derived&>(*this);
+  }
+
+  const Derived& derived() const {
+    return static_cast<const Derived&>(*this);
+  }
+
+  static ATOMIC_CONSTEXPR storage_type init_storage(const T x,
+                                                    detail::true_type) {
+    return static_cast<storage_type>(x);
+  }
+
+  static ATOMIC_CONSTEXPR storage_type init_storage(const T x,
+                                                    detail::false_type) {
+    return to_storage(x);
+  }
+
+  static ATOMIC_CONSTEXPR storage_type default_storage(detail::true_type) {
+    return static_cast<storage_type>(0);
+  }
+
+  static storage_type default_storage(detail::false_type) {
+    return to_storage(T());
+  }
+
+  storage_type load_storage(const memory_order order) const {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return ops::load(derived().storage(), order);
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    // TODO(m): Is there a better solution for MSVC?
+    (void)order;
+    return *derived().storage();
+#else
+    return derived().storage().load(detail::to_std_memory_order(order));
+#endif
+  }
+
+  bool compare_exchange_value(T& expected,
+                              const T desired,
+                              const bool weak,
+                              const memory_order success,
+                              const memory_order failure) {
+    storage_type e = to_storage(expected);
+    if (compare_exchange_storage(
+            e, to_storage(desired), weak, success, failure)) {
+      return true;
+    }
+    expected = from_storage(e);
+    return false;
+  }
+
+  // Note: On failure, expected_val is updated with the current value.
+  bool compare_exchange_storage(storage_type& expected_val,
+                                const storage_type new_val,
+                                const bool weak,
+                                const memory_order success,
+                                const memory_order failure) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return ops::compare_exchange(
+        derived().storage(), expected_val, new_val, weak, success, failure);
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    // Note: The interlocked CAS is always strong and sequentially consistent.
+    (void)weak;
+    (void)success;
+    (void)failure;
+    const storage_type e = expected_val;
+    expected_val = ops::compare_exchange(derived().storage(), new_val, e);
+    return expected_val == e;
+#else
+    return weak ? derived().storage().compare_exchange_weak(
+                      expected_val,
+                      new_val,
+                      detail::to_std_memory_order(success),
+                      detail::to_std_memory_order(failure))
+                : derived().storage().compare_exchange_strong(
+                      expected_val,
+                      new_val,
+                      detail::to_std_memory_order(success),
+                      detail::to_std_memory_order(failure));
+#endif
+  }
+
+  // A weak CAS for read-modify-write loops.
+  bool compare_exchange_storage(storage_type& expected_val,
+                                const storage_type new_val,
+                                const memory_order order) {
+    return compare_exchange_storage(
+        expected_val, new_val, true, order, detail::load_order(order));
+  }
+
+  // Integer arithmetic.
+  T fetch_add(const T x, const memory_order order, detail::false_type) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return from_storage(
+        ops::fetch_add(derived().storage(), to_storage(x), order));
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    (void)order;
+    return from_storage(ops::fetch_add(derived().storage(), to_storage(x)));
+#else
+    return derived().storage().fetch_add(x, detail::to_std_memory_order(order));
+#endif
+  }
+
+  T fetch_sub(const T x, const memory_order order, detail::false_type) {
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+    return from_storage(
+        ops::fetch_sub(derived().storage(), to_storage(x), order));
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+    (void)order;
+    return from_storage(ops::fetch_add(
+        derived().storage(), static_cast<storage_type>(0 - to_storage(x))));
+#else
+    return derived().storage().fetch_sub(x, detail::to_std_memory_order(order));
+#endif
+  }
+
+  // Floating point arithmetic (there are no atomic floating point
+  // instructions, so we use CAS loops).
+  T fetch_add(const T x, const memory_order order, detail::true_type) {
+    storage_type old_val = load_storage(detail::load_order(order));
+    while (!compare_exchange_storage(
+        old_val, to_storage(from_storage(old_val) + x), order))
+      ;
+    return from_storage(old_val);
+  }
+
+  T fetch_sub(const T x, const memory_order order, detail::true_type) {
+    storage_type old_val = load_storage(detail::load_order(order));
+    while (!compare_exchange_storage(
+        old_val, to_storage(from_storage(old_val) - x), order))
+      ;
+    return from_storage(old_val);
+  }
+
+  // Max/min with a CAS loop (any type that has operator<).
+  T fetch_max(storage_type old_val,
+              const T x,
+              const memory_order order,
+              detail::false_type) {
+    const storage_type new_val = to_storage(x);
+    while (from_storage(old_val) < x &&
+           !compare_exchange_storage(old_val, new_val, order))
+      ;
+    return from_storage(old_val);
+  }
+
+  T fetch_min(storage_type old_val,
+              const T x,
+              const memory_order order,
+              detail::false_type) {
+    const storage_type new_val = to_storage(x);
+    while (x < from_storage(old_val) &&
+           !compare_exchange_storage(old_val, new_val, order))
+      ;
+    return from_storage(old_val);
+  }
+
+  // Max/min for integer types.
+  T fetch_max(const storage_type old_val,
+              const T x,
+              const memory_order order,
+              detail::true_type) {
+#if defined(ATOMIC_USE_AARCH64_LSE)
+    if (aarch64::has_lse()) {
+      typedef aarch64::lse_ops<storage_type> lse;
+      return from_storage(
+          detail::is_signed<T>::value
+              ? lse::fetch_smax(derived().storage(), to_storage(x), order)
+              : lse::fetch_umax(derived().storage(), to_storage(x), order));
+    }
+#endif
+    return fetch_max(old_val, x, order, detail::false_type());
+  }
+
+  T fetch_min(const storage_type old_val,
+              const T x,
+              const memory_order order,
+              detail::true_type) {
+#if defined(ATOMIC_USE_AARCH64_LSE)
+    if (aarch64::has_lse()) {
+      typedef aarch64::lse_ops<storage_type> lse;
+      return from_storage(
+          detail::is_signed<T>::value
+              ? lse::fetch_smin(derived().storage(), to_storage(x), order)
+              : lse::fetch_umin(derived().storage(), to_storage(x), order));
+    }
+#endif
+    return fetch_min(old_val, x, order, detail::false_type());
+  }
+};
+}  // namespace detail
+
+/// @brief An atomic object.
+///
+/// T can be an integer, a pointer, a floating point type or any other
+/// trivially copyable type (without padding bits) of size 1, 2, 4 or 8 bytes.
+/// 16-byte types are supported on targets that have a double-width CAS
+/// instruction (when ATOMIC_HAS_DWCAS is defined).
+///
+/// Internally the value is represented by an unsigned integer of the same size
+/// (the bits of the value), so all types use the same atomic instructions.
+/// Arithmetic operations are only available for integer and floating point
+/// types, and bitwise operations are only available for integer types.
+template <typename T>
+class atomic : public detail::atomic_base<T, atomic<T> > {
+  typedef detail::atomic_base<T, atomic<T> > base;
+  typedef typename base::storage_type storage_type;
+
+public:
+  /// @brief Construct a value-initialized atomic object (e.g. zero).
+  /// @note The constructors are constexpr (in C++11 and later) for integral
+  /// types, and the default constructor is also constexpr for floating point
+  /// and pointer types, so that global atomic objects can be
+  /// constant-initialized.
+  ATOMIC_CONSTEXPR atomic() : value_(base::default_storage()) {}
+
+  ATOMIC_CONSTEXPR explicit atomic(const T value)
+      : value_(base::init_storage(value)) {}
+
+  T operator=(const T new_value) {
+    this->store(new_value);
+    return new_value;
+  }
+
 private:
+  friend class detail::atomic_base<T, atomic<T> >;
+
 #if defined(ATOMIC_USE_GCC_INTRINSICS) || defined(ATOMIC_USE_MSVC_INTRINSICS)
-  volatile T value_;
+  volatile storage_type* storage() {
+    return &value_;
+  }
+
+  const volatile storage_type* storage() const {
+    return &value_;
+  }
+#else
+  std::atomic<T>& storage() {
+    return value_;
+  }
+
+  const std::atomic<T>& storage() const {
+    return value_;
+  }
+#endif
+
+#if defined(ATOMIC_USE_GCC_INTRINSICS)
+  // Note: The value must be naturally aligned to be atomic (e.g. 8-byte values
+  // are only 4-byte aligned by default on 32-bit x86).
+  volatile storage_type value_ __attribute__((aligned(sizeof(T))));
+#elif defined(ATOMIC_USE_MSVC_INTRINSICS)
+  volatile storage_type value_;
 #else
   std::atomic<T> value_;
 #endif
@@ -197,6 +953,7 @@ private:
 
 // Undef temporary defines.
 #undef ATOMIC_USE_GCC_INTRINSICS
+#undef ATOMIC_USE_AARCH64_LSE
 #undef ATOMIC_USE_MSVC_INTRINSICS
 #undef ATOMIC_USE_CPP11_ATOMIC
 
@@ -0,0 +1,211 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ATOMIC_AARCH64_H_
+#define ATOMIC_ATOMIC_AARCH64_H_
+
+// Operations for AArch64 that use the ARMv8.1 Large System Extensions (LSE).
+//
+// Without LSE, read-modify-write operations are LL/SC (ldxr/stxr) loops, which
+// scale poorly under contention. LSE adds single instructions for them (ldadd,
+// ldset, ldclr, swp, cas, ldsmax, ...).
+//
+// When the compiler targets LSE (e.g. -march=armv8.1-a, which defines
+// __ARM_FEATURE_ATOMICS), the GCC intrinsics already use LSE instructions, and
+// only max/min (which have no GCC intrinsics) are implemented here. For
+// generic builds on Linux, the LSE instructions are selected at run time if
+// the CPU supports them (HWCAP_ATOMICS), and the GCC intrinsics are used
+// otherwise. Define ATOMIC_NO_LSE_DISPATCH to disable run time dispatch (e.g.
+// when building with -moutline-atomics, which does the same thing).
+//
+// The operations work on the unsigned storage type of an atomic object, and
+// the signedness of max/min comparisons is selected by the caller.
+
+#if !defined(__ARM_FEATURE_ATOMICS)
+#include <sys/auxv.h>
+#ifndef HWCAP_ATOMICS
+#define HWCAP_ATOMICS (1 << 8)
+#endif
+// Allow the assembler to accept LSE instructions.
+#define ATOMIC_AARCH64_LSE_ARCH ".arch_extension lse\n\t"
+#else
+#define ATOMIC_AARCH64_LSE_ARCH ""
+#endif
+
+namespace atomic {
+namespace aarch64 {
+/// @returns true if the CPU supports the LSE instructions.
+inline bool has_lse() {
+#if defined(__ARM_FEATURE_ATOMICS)
+  return true;
+#else
+  static const bool result = (getauxval(AT_HWCAP) & HWCAP_ATOMICS) != 0;
+  return result;
+#endif
+}
+
+// Note: The ordering suffix (a, l, al) goes before the size suffix (b, h).
+#define ATOMIC_AARCH64_LSE_ASM(insn, order, size, reg)                     \
+  __asm__ __volatile__(ATOMIC_AARCH64_LSE_ARCH insn order size             \
+                       " %" reg "2, %" reg "0, %1"                         \
+                       : "=&r"(old_val), "+Q"(*x)                          \
+                       : "r"(val)                                          \
+                       : "memory")
+
+#define ATOMIC_AARCH64_LSE_OP(name, insn, size, reg)                       \
+  static inline T name(T volatile* x, const T val, const int order) {      \
+    T old_val;                                                             \
+    if (order == __ATOMIC_RELAXED) {                                       \
+      ATOMIC_AARCH64_LSE_ASM(insn, "", size, reg);                         \
+    } else if (order == __ATOMIC_CONSUME || order == __ATOMIC_ACQUIRE) {   \
+      ATOMIC_AARCH64_LSE_ASM(insn, "a", size, reg);                        \
+    } else if (order == __ATOMIC_RELEASE) {                                \
+      ATOMIC_AARCH64_LSE_ASM(insn, "l", size, reg);                        \
+    } else {                                                               \
+      ATOMIC_AARCH64_LSE_ASM(insn, "al", size, reg);                       \
+    }                                                                      \
+    return old_val;                                                        \
+  }
+
+// Note: On failure, expected_val is updated with the current value.
+#define ATOMIC_AARCH64_LSE_CAS(size, reg)                                  \
+  static inline bool compare_exchange(T volatile* x,                       \
+                                      T& expected_val,                     \
+                                      const T new_val) {                   \
+    /* Note: casal is strong and sequentially consistent. */               \
+    const T old_expected = expected_val;                                   \
+    __asm__ __volatile__(ATOMIC_AARCH64_LSE_ARCH "casal" size              \
+                         " %" reg "0, %" reg "2, %1"                       \
+                         : "+r"(expected_val), "+Q"(*x)                    \
+                         : "r"(new_val)                                    \
+                         : "memory");                                      \
+    return expected_val == old_expected;                                   \
+  }
+
+#define ATOMIC_AARCH64_LSE_OPS(size, reg)                        \
+  ATOMIC_AARCH64_LSE_OP(exchange, "swp", size, reg)              \
+  ATOMIC_AARCH64_LSE_OP(fetch_add, "ldadd", size, reg)           \
+  ATOMIC_AARCH64_LSE_OP(fetch_or, "ldset", size, reg)            \
+  ATOMIC_AARCH64_LSE_OP(fetch_clear, "ldclr", size, reg)         \
+  ATOMIC_AARCH64_LSE_OP(fetch_smax, "ldsmax", size, reg)         \
+  ATOMIC_AARCH64_LSE_OP(fetch_umax, "ldumax", size, reg)         \
+  ATOMIC_AARCH64_LSE_OP(fetch_smin, "ldsmin", size, reg)         \
+  ATOMIC_AARCH64_LSE_OP(fetch_umin, "ldumin", size, reg)         \
+  ATOMIC_AARCH64_LSE_CAS(size, reg)
+
+template <typename T, unsigned N = sizeof(T)>
+struct lse_ops {};
+
+template <typename T>
+struct lse_ops<T, 1> {
+  ATOMIC_AARCH64_LSE_OPS("b", "w")
+};
+
+template <typename T>
+struct lse_ops<T, 2> {
+  ATOMIC_AARCH64_LSE_OPS("h", "w")
+};
+
+template <typename T>
+struct lse_ops<T, 4> {
+  ATOMIC_AARCH64_LSE_OPS("", "w")
+};
+
+template <typename T>
+struct lse_ops<T, 8> {
+  ATOMIC_AARCH64_LSE_OPS("", "x")
+};
+
+#undef ATOMIC_AARCH64_LSE_OPS
+#undef ATOMIC_AARCH64_LSE_CAS
+#undef ATOMIC_AARCH64_LSE_OP
+#undef ATOMIC_AARCH64_LSE_ASM
+#undef ATOMIC_AARCH64_LSE_ARCH
+
+#if defined(__ARM_FEATURE_ATOMICS)
+// The GCC intrinsics already use LSE instructions.
+template <typename T, unsigned N = sizeof(T)>
+struct ops : gcc::ops<T> {};
+#else
+// Select LSE instructions or GCC intrinsics (LL/SC loops) at run time.
+template <typename T, unsigned N = sizeof(T)>
+struct ops : gcc::ops<T> {
+  static inline bool compare_exchange(
+      T volatile* x,
+      T& expected_val,
+      const T new_val,
+      const bool weak = false,
+      const int success_order = __ATOMIC_SEQ_CST,
+      const int failure_order = __ATOMIC_SEQ_CST) {
+    if (has_lse()) {
+      return lse_ops<T>::compare_exchange(x, expected_val, new_val);
+    }
+    return gcc::ops<T>::compare_exchange(
+        x, expected_val, new_val, weak, success_order, failure_order);
+  }
+
+  static inline T exchange(T volatile* x, const T new_val, const int order) {
+    if (has_lse()) {
+      return lse_ops<T>::exchange(x, new_val, order);
+    }
+    return gcc::ops<T>::exchange(x, new_val, order);
+  }
+
+  static inline T fetch_add(T volatile* x, const T val, const int order) {
+    if (has_lse()) {
+      return lse_ops<T>::fetch_add(x, val, order);
+    }
+    return gcc::ops<T>::fetch_add(x, val, order);
+  }
+
+  static inline T fetch_sub(T volatile* x, const T val, const int order) {
+    if (has_lse()) {
+      return lse_ops<T>::fetch_add(x, static_cast<T>(0 - val), order);
+    }
+    return gcc::ops<T>::fetch_sub(x, val, order);
+  }
+
+  static inline T fetch_or(T volatile* x, const T val, const int order) {
+    if (has_lse()) {
+      return lse_ops<T>::fetch_or(x, val, order);
+    }
+    return gcc::ops<T>::fetch_or(x, val, order);
+  }
+
+  static inline T fetch_and(T volatile* x, const T val, const int order) {
+    if (has_lse()) {
+      return lse_ops<T>::fetch_clear(x, static_cast<T>(~val), order);
+    }
+    return gcc::ops<T>::fetch_and(x, val, order);
+  }
+};
+
+// There are no 16-byte LSE operations that we use (casp is not supported).
+template <typename T>
+struct ops<T, 16> : gcc::ops<T> {};
+#endif  // __ARM_FEATURE_ATOMICS
+}  // namespace aarch64
+}  // namespace atomic
+
+#endif  // ATOMIC_ATOMIC_AARCH64_H_
@@ -0,0 +1,154 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ATOMIC_BITSET_H_
+#define ATOMIC_ATOMIC_BITSET_H_
+
+#include "atomic/atomic.h"
+#include "atomic/bit_ops.h"
+#include "atomic/thread_hint.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace atomic {
+/// @brief A fixed size bitset with atomic bit operations.
+///
+/// In addition to setting and clearing individual bits, the bitset can be used
+/// as a lock-free slot allocator: acquire_free() finds a clear bit and sets it.
+/// Different threads start their search at different words of the bitset, in
+/// order to spread contention.
+///
+/// @tparam N The number of bits.
+/// @note This class requires C++11.
+template <std::size_t N>
+class atomic_bitset {
+public:
+  /// @brief The value returned by acquire_free() when all bits are set.
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  /// @brief Construct a bitset with all bits cleared.
+  atomic_bitset() {
+    // The unused bits of the last word are permanently set, so that they are
+    // never handed out by acquire_free().
+    if ((N % BITS_PER_WORD) != 0u) {
+      words_[NUM_WORDS - 1].store(~static_cast<uint64_t>(0)
+                                  << (N % BITS_PER_WORD));
+    }
+  }
+
+  /// @returns the number of bits in the bitset.
+  static std::size_t size() {
+    return N;
+  }
+
+  /// @param pos The index of the bit.
+  /// @returns the value of the bit.
+  bool test(const std::size_t pos) const {
+    return (words_[pos / BITS_PER_WORD].load() & mask_for(pos)) != 0u;
+  }
+
+  /// @brief Atomically set a bit.
+  /// @param pos The index of the bit.
+  /// @returns the old value of the bit.
+  bool test_and_set(const std::size_t pos) {
+    const uint64_t mask = mask_for(pos);
+    return (words_[pos / BITS_PER_WORD].fetch_or(mask) & mask) != 0u;
+  }
+
+  /// @brief Atomically clear a bit.
+  /// @param pos The index of the bit.
+  /// @returns the old value of the bit.
+  bool reset(const std::size_t pos) {
+    const uint64_t mask = mask_for(pos);
+    return (words_[pos / BITS_PER_WORD].fetch_and(~mask) & mask) != 0u;
+  }
+
+  /// @brief Find a clear bit and atomically set it.
+  ///
+  /// The search starts at a per-thread hint, so concurrent callers usually
+  /// operate on different words.
+  ///
+  /// @returns the index of the bit that was set, or npos if all bits are set.
+  std::size_t acquire_free() {
+    std::size_t& hint = detail::thread_hint();
+    const std::size_t start = hint % NUM_WORDS;
+    for (std::size_t n = 0; n < NUM_WORDS; ++n) {
+      std::size_t w = start + n;
+      if (w >= NUM_WORDS) {
+        w -= NUM_WORDS;
+      }
+      uint64_t word = words_[w].load();
+      while (word != ~static_cast<uint64_t>(0)) {
+        const unsigned bit = detail::count_trailing_zeros(~word);
+        const uint64_t mask = static_cast<uint64_t>(1) << bit;
+        const uint64_t old_word = words_[w].fetch_or(mask);
+        if ((old_word & mask) == 0u) {
+          hint = w;
+          return w * BITS_PER_WORD + bit;
+        }
+
+        // Someone else got the bit first: retry with the fresh word.
+        word = old_word;
+      }
+    }
+    return npos;
+  }
+
+  /// @returns the number of set bits.
+  /// @note The returned value may be outdated if other threads modify the
+  /// bitset.
+  std::size_t count() const {
+    std::size_t result = 0u;
+    for (std::size_t w = 0; w < NUM_WORDS; ++w) {
+      result += detail::population_count(words_[w].load());
+    }
+    if ((N % BITS_PER_WORD) != 0u) {
+      result -= BITS_PER_WORD - (N % BITS_PER_WORD);
+    }
+    return result;
+  }
+
+private:
+  static const std::size_t BITS_PER_WORD = 64u;
+  static const std::size_t NUM_WORDS =
+      (N + BITS_PER_WORD - 1u) / BITS_PER_WORD;
+
+  ATOMIC_STATIC_ASSERT(N > 0u, "The bitset must have at least one bit");
+
+  static uint64_t mask_for(const std::size_t pos) {
+    return static_cast<uint64_t>(1) << (pos % BITS_PER_WORD);
+  }
+
+  atomic<uint64_t> words_[NUM_WORDS];
+
+  ATOMIC_DISALLOW_COPY(atomic_bitset)
+};
+
+template <std::size_t N>
+const std::size_t atomic_bitset<N>::npos;
+
+}  // namespace atomic
+
+#endif  // ATOMIC_ATOMIC_BITSET_H_
@@ -0,0 +1,162 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ATOMIC_GCC_H_
+#define ATOMIC_ATOMIC_GCC_H_
+
+// Operations for GCC compatible compilers.
+//
+// The operations work on unsigned integer types (the bit representation of the
+// value of an atomic object). Values of size 1, 2, 4 and 8 use the GCC
+// intrinsics. Targets that need special treatment for some sizes specialize
+// the ops template below.
+
+namespace atomic {
+namespace gcc {
+template <typename T, unsigned N = sizeof(T)>
+struct ops {
+  static inline T load(T const volatile* x, const int order) {
+    return __atomic_load_n(x, order);
+  }
+
+  static inline void store(T volatile* x, const T new_val, const int order) {
+    __atomic_store_n(x, new_val, order);
+  }
+
+  // Note: On failure, expected_val is updated with the current value.
+  static inline bool compare_exchange(
+      T volatile* x,
+      T& expected_val,
+      const T new_val,
+      const bool weak = false,
+      const int success_order = __ATOMIC_SEQ_CST,
+      const int failure_order = __ATOMIC_SEQ_CST) {
+    return __atomic_compare_exchange_n(
+        x, &expected_val, new_val, weak, success_order, failure_order);
+  }
+
+  static inline T exchange(T volatile* x, const T new_val, const int order) {
+    return __atomic_exchange_n(x, new_val, order);
+  }
+
+  static inline T fetch_add(T volatile* x, const T val, const int order) {
+    return __atomic_fetch_add(x, val, order);
+  }
+
+  static inline T fetch_sub(T volatile* x, const T val, const int order) {
+    return __atomic_fetch_sub(x, val, order);
+  }
+
+  static inline T fetch_or(T volatile* x, const T val, const int order) {
+    return __atomic_fetch_or(x, val, order);
+  }
+
+  static inline T fetch_and(T volatile* x, const T val, const int order) {
+    return __atomic_fetch_and(x, val, order);
+  }
+};
+
+#if defined(ATOMIC_HAS_DWCAS)
+// 16-byte values are only supported when the target has a double-width CAS
+// instruction (e.g. cmpxchg16b on x86-64, enabled with -mcx16). The __atomic
+// intrinsics call libatomic for 16-byte values, so we use the __sync
+// intrinsics (which are inlined) and implement all the operations as CAS
+// operations.
+template <typename T>
+struct ops<T, 16> {
+  // Note: There is no plain 16-byte load that is guaranteed to be atomic, so
+  // a load is a CAS that writes back the current value. Hence the atomic
+  // object must not be placed in read-only memory.
+  static inline T load(T const volatile* x, const int order) {
+    (void)order;
+    return __sync_val_compare_and_swap(
+        const_cast<T volatile*>(x), static_cast<T>(0), static_cast<T>(0));
+  }
+
+  static inline void store(T volatile* x, const T new_val, const int order) {
+    (void)exchange(x, new_val, order);
+  }
+
+  // Note: On failure, expected_val is updated with the current value.
+  static inline bool compare_exchange(
+      T volatile* x,
+      T& expected_val,
+      const T new_val,
+      const bool weak = false,
+      const int success_order = __ATOMIC_SEQ_CST,
+      const int failure_order = __ATOMIC_SEQ_CST) {
+    // Note: The CAS instruction is always strong and sequentially consistent.
+    (void)weak;
+    (void)success_order;
+    (void)failure_order;
+    const T old_val = __sync_val_compare_and_swap(x, expected_val, new_val);
+    const bool success = (old_val == expected_val);
+    expected_val = old_val;
+    return success;
+  }
+
+  static inline T exchange(T volatile* x, const T new_val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, new_val))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_add(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val + val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_sub(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val - val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_or(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val | val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_and(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val & val)))
+      ;
+    return old_val;
+  }
+};
+#endif  // ATOMIC_HAS_DWCAS
+}  // namespace gcc
+}  // namespace atomic
+
+#if defined(__i386__)
+#include "atomic_i386.h"
+#endif
+
+#endif  // ATOMIC_ATOMIC_GCC_H_
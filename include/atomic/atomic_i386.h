@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ATOMIC_I386_H_
+#define ATOMIC_ATOMIC_I386_H_
+
+// Operations on 8-byte values for 32-bit x86 (GCC compatible compilers).
+//
+// For 8-byte values, the compiler may emit calls to libatomic (which may use
+// locks), or sequences whose atomicity depends on the compiler version and the
+// target CPU. Here we use instructions that are always atomic for naturally
+// aligned 8-byte values on i586 and later:
+//  - Loads and stores use an SSE2 movq (or an x87 fild/fistp pair when SSE2
+//    is not available).
+//  - Read-modify-write operations use lock cmpxchg8b.
+//
+// Values of other sizes use the regular GCC intrinsics (see atomic_gcc.h).
+
+namespace atomic {
+namespace gcc {
+template <typename T>
+struct ops<T, 8> {
+  static inline T load(T const volatile* x, const int order) {
+    (void)order;
+    T result;
+#if defined(__SSE2__)
+    __asm__ __volatile__(
+        "movq %1, %%xmm0\n\t"
+        "movq %%xmm0, %0"
+        : "=m"(result)
+        : "m"(*x)
+        : "xmm0", "memory");
+#else
+    __asm__ __volatile__(
+        "fildll %1\n\t"
+        "fistpll %0"
+        : "=m"(result)
+        : "m"(*x)
+        : "memory");
+#endif
+    return result;
+  }
+
+  static inline void store(T volatile* x, const T new_val, const int order) {
+#if defined(__SSE2__)
+    __asm__ __volatile__(
+        "movq %1, %%xmm0\n\t"
+        "movq %%xmm0, %0"
+        : "=m"(*x)
+        : "m"(new_val)
+        : "xmm0", "memory");
+#else
+    __asm__ __volatile__(
+        "fildll %1\n\t"
+        "fistpll %0"
+        : "=m"(*x)
+        : "m"(new_val)
+        : "memory");
+#endif
+    if (order == __ATOMIC_SEQ_CST) {
+      // A locked instruction is a full barrier (and cheaper than mfence).
+      __asm__ __volatile__("lock; orl $0, (%%esp)" ::: "memory", "cc");
+    }
+  }
+
+  // Note: On failure, expected_val is updated with the current value.
+  static inline bool compare_exchange(
+      T volatile* x,
+      T& expected_val,
+      const T new_val,
+      const bool weak = false,
+      const int success_order = __ATOMIC_SEQ_CST,
+      const int failure_order = __ATOMIC_SEQ_CST) {
+    // Note: The CAS instruction is always strong and sequentially consistent.
+    (void)weak;
+    (void)success_order;
+    (void)failure_order;
+    const unsigned long long desired = static_cast<unsigned long long>(new_val);
+    unsigned long long expected = static_cast<unsigned long long>(expected_val);
+    bool success;
+    __asm__ __volatile__(
+        "lock; cmpxchg8b %1\n\t"
+        "sete %0"
+        : "=q"(success), "+m"(*x), "+A"(expected)
+        : "b"(static_cast<unsigned>(desired)),
+          "c"(static_cast<unsigned>(desired >> 32))
+        : "memory", "cc");
+    expected_val = static_cast<T>(expected);
+    return success;
+  }
+
+  static inline T exchange(T volatile* x, const T new_val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, new_val))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_add(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val + val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_sub(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val - val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_or(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val | val)))
+      ;
+    return old_val;
+  }
+
+  static inline T fetch_and(T volatile* x, const T val, const int order) {
+    T old_val = load(x, order);
+    while (!compare_exchange(x, old_val, static_cast<T>(old_val & val)))
+      ;
+    return old_val;
+  }
+};
+}  // namespace gcc
+}  // namespace atomic
+
+#endif  // ATOMIC_ATOMIC_I386_H_
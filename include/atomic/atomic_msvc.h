@@ -44,9 +44,38 @@ char _InterlockedCompareExchange8(char volatile*, char, char);
 short _InterlockedCompareExchange16(short volatile*, short, short);
 long __cdecl _InterlockedCompareExchange(long volatile*, long, long);
 __int64 _InterlockedCompareExchange64(__int64 volatile*, __int64, __int64);
+
+char _InterlockedExchangeAdd8(char volatile*, char);
+short _InterlockedExchangeAdd16(short volatile*, short);
+long __cdecl _InterlockedExchangeAdd(long volatile*, long);
+__int64 _InterlockedExchangeAdd64(__int64 volatile*, __int64);
+
+void _ReadWriteBarrier(void);
+#if defined(_M_X64)
+void __faststorefence(void);
+#elif defined(_M_ARM) || defined(_M_ARM64)
+void __dmb(unsigned int);
+#endif
+
+char _InterlockedOr8(char volatile*, char);
+short _InterlockedOr16(short volatile*, short);
+long _InterlockedOr(long volatile*, long);
+__int64 _InterlockedOr64(__int64 volatile*, __int64);
+
+char _InterlockedAnd8(char volatile*, char);
+short _InterlockedAnd16(short volatile*, short);
+long _InterlockedAnd(long volatile*, long);
+__int64 _InterlockedAnd64(__int64 volatile*, __int64);
 };
 
 // Define which functions we want to use as inline intriniscs.
+#pragma intrinsic(_ReadWriteBarrier)
+#if defined(_M_X64)
+#pragma intrinsic(__faststorefence)
+#elif defined(_M_ARM) || defined(_M_ARM64)
+#pragma intrinsic(__dmb)
+#endif
+
 #pragma intrinsic(_InterlockedIncrement)
 #pragma intrinsic(_InterlockedIncrement16)
 
@@ -61,15 +90,53 @@ __int64 _InterlockedCompareExchange64(__int64 volatile*, __int64, __int64);
 #pragma intrinsic(_InterlockedExchange8)
 #pragma intrinsic(_InterlockedExchange16)
 
+#pragma intrinsic(_InterlockedExchangeAdd)
+#pragma intrinsic(_InterlockedExchangeAdd8)
+#pragma intrinsic(_InterlockedExchangeAdd16)
+
+#pragma intrinsic(_InterlockedOr)
+#pragma intrinsic(_InterlockedOr8)
+#pragma intrinsic(_InterlockedOr16)
+
+#pragma intrinsic(_InterlockedAnd)
+#pragma intrinsic(_InterlockedAnd8)
+#pragma intrinsic(_InterlockedAnd16)
+
 #if defined(_M_X64)
 #pragma intrinsic(_InterlockedIncrement64)
 #pragma intrinsic(_InterlockedDecrement64)
 #pragma intrinsic(_InterlockedCompareExchange64)
 #pragma intrinsic(_InterlockedExchange64)
+#pragma intrinsic(_InterlockedExchangeAdd64)
+#pragma intrinsic(_InterlockedOr64)
+#pragma intrinsic(_InterlockedAnd64)
 #endif  // _M_X64
 
 namespace atomic {
 namespace msvc {
+/// @brief A full (sequentially consistent) memory barrier.
+inline void full_fence() {
+#if defined(_M_X64)
+  __faststorefence();
+#elif defined(_M_ARM) || defined(_M_ARM64)
+  __dmb(0xB);  // _ARM64_BARRIER_ISH
+#else
+  // Any locked instruction is a full barrier on x86.
+  long dummy = 0;
+  (void)_InterlockedOr(&dummy, 0);
+#endif
+}
+
+/// @brief A memory barrier that is sufficient for acquire/release ordering.
+inline void acq_rel_fence() {
+#if defined(_M_ARM) || defined(_M_ARM64)
+  __dmb(0xB);  // _ARM64_BARRIER_ISH
+#else
+  // x86 only reorders stores after loads, so a compiler barrier is enough.
+  _ReadWriteBarrier();
+#endif
+}
+
 template <typename T, size_t N = sizeof(T)>
 struct interlocked {
 };
@@ -113,6 +180,22 @@ struct interlocked<T, 1> {
     return static_cast<T>(_InterlockedExchange8(
         reinterpret_cast<volatile char*>(x), static_cast<const char>(new_val)));
   }
+
+  static inline T fetch_add(T volatile* x, const T val) {
+    return static_cast<T>(
+        _InterlockedExchangeAdd8(reinterpret_cast<volatile char*>(x),
+                                 static_cast<const char>(val)));
+  }
+
+  static inline T fetch_or(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedOr8(reinterpret_cast<volatile char*>(x),
+                                          static_cast<const char>(val)));
+  }
+
+  static inline T fetch_and(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedAnd8(reinterpret_cast<volatile char*>(x),
+                                           static_cast<const char>(val)));
+  }
 };
 
 template <typename T>
@@ -141,6 +224,22 @@ struct interlocked<T, 2> {
         _InterlockedExchange16(reinterpret_cast<volatile short*>(x),
                                static_cast<const short>(new_val)));
   }
+
+  static inline T fetch_add(T volatile* x, const T val) {
+    return static_cast<T>(
+        _InterlockedExchangeAdd16(reinterpret_cast<volatile short*>(x),
+                                  static_cast<const short>(val)));
+  }
+
+  static inline T fetch_or(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedOr16(
+        reinterpret_cast<volatile short*>(x), static_cast<const short>(val)));
+  }
+
+  static inline T fetch_and(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedAnd16(
+        reinterpret_cast<volatile short*>(x), static_cast<const short>(val)));
+  }
 };
 
 template <typename T>
@@ -168,6 +267,22 @@ struct interlocked<T, 4> {
     return static_cast<T>(_InterlockedExchange(
         reinterpret_cast<volatile long*>(x), static_cast<const long>(new_val)));
   }
+
+  static inline T fetch_add(T volatile* x, const T val) {
+    return static_cast<T>(
+        _InterlockedExchangeAdd(reinterpret_cast<volatile long*>(x),
+                                static_cast<const long>(val)));
+  }
+
+  static inline T fetch_or(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedOr(reinterpret_cast<volatile long*>(x),
+                                         static_cast<const long>(val)));
+  }
+
+  static inline T fetch_and(T volatile* x, const T val) {
+    return static_cast<T>(_InterlockedAnd(reinterpret_cast<volatile long*>(x),
+                                          static_cast<const long>(val)));
+  }
 };
 
 template <typename T>
@@ -229,6 +344,60 @@ struct interlocked<T, 8> {
                  reinterpret_cast<volatile __int64*>(x), new_val, old_val) !=
              old_val);
     return static_cast<T>(old_val);
+#endif  // _M_X64
+  }
+
+  static inline T fetch_add(T volatile* x, const T val) {
+#if defined(_M_X64)
+    return static_cast<T>(
+        _InterlockedExchangeAdd64(reinterpret_cast<volatile __int64*>(x),
+                                  static_cast<const __int64>(val)));
+#else
+    // There's no _InterlockedExchangeAdd64 for 32-bit x86.
+    __int64 old_val;
+    do {
+      old_val = static_cast<__int64>(*x);
+    } while (_InterlockedCompareExchange64(
+                 reinterpret_cast<volatile __int64*>(x),
+                 old_val + static_cast<const __int64>(val),
+                 old_val) != old_val);
+    return static_cast<T>(old_val);
+#endif  // _M_X64
+  }
+
+  static inline T fetch_or(T volatile* x, const T val) {
+#if defined(_M_X64)
+    return static_cast<T>(
+        _InterlockedOr64(reinterpret_cast<volatile __int64*>(x),
+                         static_cast<const __int64>(val)));
+#else
+    // There's no _InterlockedOr64 for 32-bit x86.
+    __int64 old_val;
+    do {
+      old_val = static_cast<__int64>(*x);
+    } while (_InterlockedCompareExchange64(
+                 reinterpret_cast<volatile __int64*>(x),
+                 old_val | static_cast<const __int64>(val),
+                 old_val) != old_val);
+    return static_cast<T>(old_val);
+#endif  // _M_X64
+  }
+
+  static inline T fetch_and(T volatile* x, const T val) {
+#if defined(_M_X64)
+    return static_cast<T>(
+        _InterlockedAnd64(reinterpret_cast<volatile __int64*>(x),
+                          static_cast<const __int64>(val)));
+#else
+    // There's no _InterlockedAnd64 for 32-bit x86.
+    __int64 old_val;
+    do {
+      old_val = static_cast<__int64>(*x);
+    } while (_InterlockedCompareExchange64(
+                 reinterpret_cast<volatile __int64*>(x),
+                 old_val & static_cast<const __int64>(val),
+                 old_val) != old_val);
+    return static_cast<T>(old_val);
 #endif  // _M_X64
   }
 };
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_ATOMIC_REF_H_
+#define ATOMIC_ATOMIC_REF_H_
+
+#include "atomic/atomic.h"
+
+#include <cassert>
+#include <cstddef>
+
+namespace atomic {
+/// @brief Atomic operations on an existing object.
+///
+/// This is similar to C++20 std::atomic_ref, and makes it possible to use
+/// atomic operations on plain memory (e.g. large arrays or memory mapped data)
+/// without copying it into atomic objects. The same types and operations as
+/// for atomic<T> are supported (they share the same implementation).
+///
+/// The referenced object must be aligned to @c required_alignment (which may
+/// be stricter than the alignment of T, e.g. for 8-byte values on 32-bit x86).
+/// While any atomic_ref refers to an object, the object must only be accessed
+/// through atomic_ref instances.
+///
+/// @note When std::atomic is used as a fallback, this class requires C++20.
+template <typename T>
+class atomic_ref : public detail::atomic_base<T, atomic_ref<T> > {
+  typedef detail::atomic_base<T, atomic_ref<T> > base;
+
+public:
+#if !defined(ATOMIC_HAS_ATOMIC_REF)
+  ATOMIC_STATIC_ASSERT(sizeof(T) == 0,
+                       "atomic_ref requires compiler intrinsics or C++20");
+#endif
+
+  /// @brief The required alignment of referenced objects.
+  static const std::size_t required_alignment = sizeof(T);
+
+  /// @brief Construct a reference to an object.
+  /// @param obj The object, which must be aligned to @c required_alignment.
+  explicit atomic_ref(T& obj) : ptr_(&obj) {
+    assert(is_aligned(&obj) && "atomic_ref: The object is misaligned");
+  }
+
+  atomic_ref(const atomic_ref& other) : base(), ptr_(other.ptr_) {}
+
+  T operator=(const T new_value) {
+    this->store(new_value);
+    return new_value;
+  }
+
+  /// @param ptr A pointer to an object.
+  /// @returns true if the object is suitably aligned for atomic_ref.
+  static bool is_aligned(const T* ptr) {
+    return (reinterpret_cast<std::size_t>(ptr) & (required_alignment - 1u)) ==
+           0u;
+  }
+
+private:
+  friend class detail::atomic_base<T, atomic_ref<T> >;
+
+  typename base::storage_ref storage() const {
+    return base::storage_of(ptr_);
+  }
+
+  // Note: Like std::atomic_ref, an atomic_ref can not be re-seated.
+  atomic_ref& operator=(const atomic_ref&);
+
+  T* const ptr_;
+};
+
+template <typename T>
+const std::size_t atomic_ref<T>::required_alignment;
+
+}  // namespace atomic
+
+#endif  // ATOMIC_ATOMIC_REF_H_
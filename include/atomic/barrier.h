@@ -0,0 +1,167 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_BARRIER_H_
+#define ATOMIC_BARRIER_H_
+
+#include "atomic/atomic.h"
+#include "atomic/wait.h"
+
+#include <memory>
+
+namespace atomic {
+/// @brief A sense-reversing spinning barrier.
+///
+/// All participating threads call arrive_and_wait(), which blocks (spins) until
+/// all the threads have arrived. The barrier is reusable, i.e. it can be used
+/// for several phases in a row.
+///
+/// All threads spin on a single shared word, which works well for a moderate
+/// number of threads. For many threads (more than about 32), consider using a
+/// combining_tree_barrier instead.
+class spin_barrier {
+public:
+  /// @brief Construct a barrier.
+  /// @param num_threads The number of participating threads.
+  explicit spin_barrier(const int num_threads)
+      : num_threads_(num_threads), sense_(0) {
+    arrivals_.count.store(num_threads);
+  }
+
+  /// @brief Wait for all the participating threads to arrive.
+  /// @returns true for exactly one of the threads (the last one to arrive).
+  bool arrive_and_wait() {
+    // Note: The sense can not change until all threads have arrived, so it is
+    // safe to read it before arriving.
+    const int sense = sense_.load();
+    if (--arrivals_.count == 0) {
+      arrivals_.count.store(num_threads_);
+      sense_.store(sense ^ 1);
+      return true;
+    }
+    detail::spin_backoff backoff;
+    while (sense_.load() == sense) {
+      backoff.pause();
+    }
+    return false;
+  }
+
+private:
+  // The arrival counter and the sense are kept in different cache lines, so
+  // that arriving threads do not disturb the spinning threads.
+  struct padded_counter {
+    atomic<int> count;
+    char padding[ATOMIC_CACHE_LINE_SIZE];
+  };
+
+  const int num_threads_;
+  padded_counter arrivals_;
+  atomic<int> sense_;
+
+  ATOMIC_DISALLOW_COPY(spin_barrier)
+};
+
+/// @brief A sense-reversing combining tree barrier.
+///
+/// Threads arrive at the leaves of a tree of counters, and only the last
+/// thread to arrive at a node continues to the parent node. This spreads the
+/// arrival traffic over many cache lines, which scales better than a
+/// spin_barrier for large numbers of threads.
+///
+/// @note This class requires C++11.
+class combining_tree_barrier {
+public:
+  /// @brief Construct a barrier.
+  /// @param num_threads The number of participating threads.
+  /// @param fan_in The maximum number of arrivals at each node of the tree.
+  explicit combining_tree_barrier(const int num_threads, const int fan_in = 4)
+      : fan_in_(fan_in > 1 ? fan_in : 2), sense_(0) {
+    // Count the nodes of all the levels of the tree.
+    int num_nodes = 0;
+    for (int n = num_threads; n > 1 || num_nodes == 0;) {
+      n = (n + fan_in_ - 1) / fan_in_;
+      num_nodes += n;
+    }
+    nodes_.reset(new node[num_nodes]);
+
+    // Set up the nodes, one level at a time (leaves first).
+    int first = 0;
+    for (int n = num_threads; n > 1 || first == 0;) {
+      const int level_size = (n + fan_in_ - 1) / fan_in_;
+      const int next_first = first + level_size;
+      for (int i = 0; i < level_size; ++i) {
+        const int arrivals = (i < level_size - 1) ? fan_in_ : n - i * fan_in_;
+        nodes_[first + i].expected = arrivals;
+        nodes_[first + i].count.store(arrivals);
+        nodes_[first + i].parent =
+            (level_size > 1) ? next_first + i / fan_in_ : -1;
+      }
+      first = next_first;
+      n = level_size;
+    }
+  }
+
+  /// @brief Wait for all the participating threads to arrive.
+  /// @param thread_id The ID of the calling thread (in the range [0,
+  /// num_threads), unique for each participating thread).
+  /// @returns true for exactly one of the threads (the last one to arrive).
+  bool arrive_and_wait(const int thread_id) {
+    const int sense = sense_.load();
+    int n = thread_id / fan_in_;
+    while (--nodes_[n].count == 0) {
+      // We are the last to arrive at this node: reset it for the next phase
+      // and continue to the parent node.
+      nodes_[n].count.store(nodes_[n].expected);
+      n = nodes_[n].parent;
+      if (n < 0) {
+        sense_.store(sense ^ 1);
+        return true;
+      }
+    }
+    detail::spin_backoff backoff;
+    while (sense_.load() == sense) {
+      backoff.pause();
+    }
+    return false;
+  }
+
+private:
+  struct node {
+    atomic<int> count;
+    int expected;
+    int parent;
+    char padding[ATOMIC_CACHE_LINE_SIZE - sizeof(atomic<int>) -
+                 2 * sizeof(int)];
+  };
+
+  const int fan_in_;
+  std::unique_ptr<node[]> nodes_;
+  atomic<int> sense_;
+
+  ATOMIC_DISALLOW_COPY(combining_tree_barrier)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_BARRIER_H_
@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_BIT_OPS_H_
+#define ATOMIC_BIT_OPS_H_
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+extern "C" {
+unsigned char _BitScanForward(unsigned long*, unsigned long);
+unsigned char _BitScanReverse(unsigned long*, unsigned long);
+#if defined(_M_X64)
+unsigned char _BitScanForward64(unsigned long*, unsigned __int64);
+unsigned char _BitScanReverse64(unsigned long*, unsigned __int64);
+#endif
+};
+#pragma intrinsic(_BitScanForward)
+#pragma intrinsic(_BitScanReverse)
+#if defined(_M_X64)
+#pragma intrinsic(_BitScanForward64)
+#pragma intrinsic(_BitScanReverse64)
+#endif
+#endif
+
+namespace atomic {
+namespace detail {
+/// @returns the index of the least significant set bit of x.
+/// @note The result is undefined if x is zero.
+inline unsigned count_trailing_zeros(const uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanForward64(&idx, x);
+  return static_cast<unsigned>(idx);
+#elif defined(_MSC_VER)
+  unsigned long idx;
+  if (_BitScanForward(&idx, static_cast<unsigned long>(x))) {
+    return static_cast<unsigned>(idx);
+  }
+  _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+  return static_cast<unsigned>(idx) + 32u;
+#else
+  unsigned idx = 0u;
+  while ((x & (static_cast<uint64_t>(1) << idx)) == 0u) {
+    ++idx;
+  }
+  return idx;
+#endif
+}
+
+/// @returns the index of the most significant set bit of x.
+/// @note The result is undefined if x is zero.
+inline unsigned most_significant_bit(const uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx;
+  _BitScanReverse64(&idx, x);
+  return static_cast<unsigned>(idx);
+#elif defined(_MSC_VER)
+  unsigned long idx;
+  if (_BitScanReverse(&idx, static_cast<unsigned long>(x >> 32))) {
+    return static_cast<unsigned>(idx) + 32u;
+  }
+  _BitScanReverse(&idx, static_cast<unsigned long>(x));
+  return static_cast<unsigned>(idx);
+#else
+  unsigned idx = 63u;
+  while ((x & (static_cast<uint64_t>(1) << idx)) == 0u) {
+    --idx;
+  }
+  return idx;
+#endif
+}
+
+/// @returns the number of set bits in x.
+inline unsigned population_count(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+  unsigned count = 0u;
+  for (; x != 0u; x &= x - 1u) {
+    ++count;
+  }
+  return count;
+#endif
+}
+}  // namespace detail
+}  // namespace atomic
+
+#endif  // ATOMIC_BIT_OPS_H_
@@ -0,0 +1,217 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_COHORT_LOCK_H_
+#define ATOMIC_COHORT_LOCK_H_
+
+#include "atomic/atomic.h"
+#include "atomic/wait.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 29)
+#define ATOMIC_COHORT_USE_GETCPU
+#endif
+#endif
+#endif
+
+namespace atomic {
+namespace detail {
+/// @returns the NUMA node of the CPU that the calling thread is running on.
+inline unsigned current_numa_node() {
+#if defined(ATOMIC_COHORT_USE_GETCPU)
+  // Note: getcpu() is implemented in the vDSO, so it is cheap.
+  unsigned cpu;
+  unsigned node;
+  if (getcpu(&cpu, &node) == 0) {
+    return node;
+  }
+#elif defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, static_cast<void*>(0)) == 0) {
+    return node;
+  }
+#endif
+  return 0u;
+}
+
+/// @returns the number of NUMA nodes that the system may have.
+inline std::size_t num_numa_nodes() {
+  std::size_t result = 1u;
+#if defined(__linux__)
+  // The file holds a list of node ranges, e.g. "0-3", where the last number
+  // is the highest possible node.
+  if (FILE* f = std::fopen("/sys/devices/system/node/possible", "r")) {
+    unsigned highest = 0u;
+    unsigned x;
+    while (std::fscanf(f, "%u", &x) == 1) {
+      highest = x;
+      (void)std::fgetc(f);  // Skip the separator.
+    }
+    std::fclose(f);
+    result = static_cast<std::size_t>(highest) + 1u;
+  }
+#endif
+  return result;
+}
+
+/// @brief A ticket lock that can tell if there are threads waiting for it.
+///
+/// The lock is thread-oblivious, i.e. it may be released by another thread
+/// than the one that acquired it.
+class ticket_lock {
+public:
+  ticket_lock() : next_(0u), serving_(0u) {}
+
+  void lock() {
+    const unsigned ticket = next_.fetch_add(1u, memory_order_relaxed);
+    spin_backoff backoff;
+    while (serving_.load(memory_order_acquire) != ticket) {
+      backoff.pause();
+    }
+  }
+
+  void unlock() {
+    serving_.store(serving_.load(memory_order_relaxed) + 1u,
+                   memory_order_release);
+  }
+
+  /// @returns true if other threads are waiting for the lock.
+  /// @note Must only be called by the holder of the lock.
+  bool has_waiters() const {
+    return next_.load(memory_order_relaxed) -
+               serving_.load(memory_order_relaxed) >
+           1u;
+  }
+
+private:
+  atomic<unsigned> next_;
+  atomic<unsigned> serving_;
+
+  ATOMIC_DISALLOW_COPY(ticket_lock)
+};
+}  // namespace detail
+
+/// @brief A NUMA-aware lock.
+///
+/// The lock is a cohort lock (Dice, Marathe and Shavit, "Lock Cohorting: A
+/// General Technique for Designing NUMA Locks"). Each NUMA node has a local
+/// ticket lock, and a global ticket lock is held by one node at a time. A
+/// thread first takes the lock of its node, and then the global lock, unless
+/// the previous holder on the same node passed the global lock on to it.
+///
+/// When the lock is released and other threads of the same node are waiting,
+/// ownership is handed over to the next one of them without releasing the
+/// global lock, so that the data that is protected by the lock stays in the
+/// caches of the node. After @c max_local_handoffs handoffs in a row the
+/// global lock is released, to give other nodes a chance.
+///
+/// @note This class requires C++11.
+class cohort_lock {
+public:
+  /// @brief A function that returns the NUMA node of the calling thread.
+  typedef unsigned (*node_function)();
+
+  /// @brief Construct a lock.
+  /// @param max_local_handoffs The maximum number of times in a row that the
+  /// lock is handed over within a node.
+  /// @param num_nodes The number of NUMA nodes (zero means the number of
+  /// nodes of the system).
+  /// @param current_node A function that returns the node of the calling
+  /// thread (the result is taken modulo @c num_nodes). This can be used for
+  /// simulating a NUMA system.
+  explicit cohort_lock(
+      const unsigned max_local_handoffs = 64u,
+      const std::size_t num_nodes = 0u,
+      const node_function current_node = detail::current_numa_node)
+      : max_local_handoffs_(max_local_handoffs),
+        num_nodes_(num_nodes > 0u ? num_nodes : detail::num_numa_nodes()),
+        current_node_(current_node),
+        nodes_(new node_state[num_nodes_]),
+        owner_node_(0u) {}
+
+  /// @brief Acquire the lock (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    const std::size_t node = current_node_() % num_nodes_;
+    node_state& state = nodes_[node];
+    state.lock.lock();
+    if (!state.owns_global) {
+      global_.lock();
+      state.owns_global = true;
+    }
+    owner_node_ = node;
+  }
+
+  /// @brief Release the lock.
+  /// @note It is an error to release a lock that has not been previously
+  /// acquired.
+  void unlock() {
+    node_state& state = nodes_[owner_node_];
+    if (state.handoffs < max_local_handoffs_ && state.lock.has_waiters()) {
+      // Keep the global lock within the node.
+      ++state.handoffs;
+    } else {
+      state.handoffs = 0u;
+      state.owns_global = false;
+      global_.unlock();
+    }
+    state.lock.unlock();
+  }
+
+private:
+  // Note: The fields other than the lock are only accessed by the holder of
+  // the lock.
+  struct node_state {
+    node_state() : owns_global(false), handoffs(0u) {}
+
+    detail::ticket_lock lock;
+    bool owns_global;
+    unsigned handoffs;
+    char padding[ATOMIC_CACHE_LINE_SIZE];
+  };
+
+  const unsigned max_local_handoffs_;
+  const std::size_t num_nodes_;
+  const node_function current_node_;
+  std::unique_ptr<node_state[]> nodes_;
+  detail::ticket_lock global_;
+  std::size_t owner_node_;  // Protected by the lock.
+
+  ATOMIC_DISALLOW_COPY(cohort_lock)
+};
+}  // namespace atomic
+
+#undef ATOMIC_COHORT_USE_GETCPU
+
+#endif  // ATOMIC_COHORT_LOCK_H_
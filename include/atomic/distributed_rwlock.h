@@ -0,0 +1,163 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_DISTRIBUTED_RWLOCK_H_
+#define ATOMIC_DISTRIBUTED_RWLOCK_H_
+
+#include "atomic/asymmetric_fence.h"
+#include "atomic/atomic.h"
+#include "atomic/percpu_counter.h"
+#include "atomic/spinlock.h"
+#include "atomic/wait.h"
+
+#include <cstdint>
+
+namespace atomic {
+/// @brief A reader-writer lock that is optimized for readers.
+///
+/// Readers never write to shared cache lines: a reader only increments a
+/// per-CPU (or, when restartable sequences are not available, per-thread)
+/// counter when taking the lock, and another one when releasing it (see
+/// percpu_counter). The reader then checks a writer flag, with only an
+/// asymmetric light fence (a compiler fence) in between.
+///
+/// A writer sets the writer flag, issues an asymmetric heavy fence, and then
+/// waits until the sum of the reader releases equals the sum of the reader
+/// acquisitions. This makes writes expensive (the heavy fence is a system
+/// call, and the counters of all CPUs are scanned), so the lock is only a good
+/// fit for data that is read much more often than it is written.
+///
+/// Writers take precedence over readers: readers that arrive while the writer
+/// flag is set back off until the writer has released the lock.
+///
+/// The lock uses two cache lines per CPU.
+///
+/// @note This class requires C++11.
+class distributed_rwlock {
+public:
+  distributed_rwlock() : writer_(0) {}
+
+  /// @brief Acquire the lock in exclusive mode (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    detail::spin_backoff backoff;
+    while (writer_.exchange(1, memory_order_acquire) != 0) {
+      while (writer_.load(memory_order_relaxed) != 0) {
+        backoff.pause();
+      }
+    }
+    asymmetric_thread_fence_heavy();
+    wait_for_readers();
+  }
+
+  /// @brief Try to acquire the lock in exclusive mode (non-blocking).
+  ///
+  /// The call fails if the lock is held by a writer or by any reader, but it
+  /// is still expensive, since it issues an asymmetric heavy fence.
+  ///
+  /// @returns true if the lock was acquired.
+  bool try_lock() {
+    if (writer_.load(memory_order_relaxed) != 0 ||
+        writer_.exchange(1, memory_order_acquire) != 0) {
+      return false;
+    }
+    asymmetric_thread_fence_heavy();
+    if (!readers_drained()) {
+      writer_.store(0, memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  /// @brief Release the lock from exclusive mode.
+  void unlock() {
+    writer_.store(0, memory_order_release);
+  }
+
+  /// @brief Acquire the lock in shared mode (blocking).
+  /// @note The lock may be acquired recursively in shared mode, as long as no
+  /// writer is waiting for the lock.
+  void lock_shared() {
+    while (!try_lock_shared()) {
+      detail::spin_backoff backoff;
+      while (writer_.load(memory_order_relaxed) != 0) {
+        backoff.pause();
+      }
+    }
+  }
+
+  /// @brief Try to acquire the lock in shared mode (non-blocking).
+  /// @returns true if the lock was acquired.
+  bool try_lock_shared() {
+    acquisitions_.add(1u);
+    // Pairs with the heavy fence of a writer: Either the writer sees our
+    // acquisition, or we see the writer flag.
+    asymmetric_thread_fence_light();
+    if (writer_.load(memory_order_acquire) == 0) {
+      return true;
+    }
+    releases_.add(1u);
+    return false;
+  }
+
+  /// @brief Release the lock from shared mode.
+  void unlock_shared() {
+    // Make the reads of the critical section happen before the release is
+    // observed by a writer.
+    thread_fence(memory_order_release);
+    releases_.add(1u);
+  }
+
+private:
+  // Note: The releases are summed up before the acquisitions. Since a release
+  // is always preceded by its acquisition, the sums can only be equal when no
+  // reader holds the lock (readers that back off add to both sums).
+  bool readers_drained() const {
+    const uint64_t releases = releases_.sum();
+    thread_fence(memory_order_acquire);
+    const uint64_t acquisitions = acquisitions_.sum();
+    thread_fence(memory_order_acquire);
+    return acquisitions == releases;
+  }
+
+  void wait_for_readers() const {
+    detail::spin_backoff backoff;
+    while (!readers_drained()) {
+      backoff.pause();
+    }
+  }
+
+  percpu_counter<uint64_t> acquisitions_;
+  percpu_counter<uint64_t> releases_;
+  atomic<int> writer_;
+
+  ATOMIC_DISALLOW_COPY(distributed_rwlock)
+};
+
+/// @brief A scoped lock guard that holds a distributed_rwlock in shared mode.
+typedef basic_shared_lock_guard<distributed_rwlock> shared_lock_guard;
+}  // namespace atomic
+
+#endif  // ATOMIC_DISTRIBUTED_RWLOCK_H_
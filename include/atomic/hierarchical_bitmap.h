@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_HIERARCHICAL_BITMAP_H_
+#define ATOMIC_HIERARCHICAL_BITMAP_H_
+
+#include "atomic/atomic.h"
+#include "atomic/bit_ops.h"
+#include "atomic/thread_hint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace atomic {
+/// @brief A large bitmap with atomic bit operations and a fast free bit
+/// search.
+///
+/// The bits (level 0) are backed by 64-bit words. On top of that there are
+/// summary levels where each bit tells if the corresponding word of the level
+/// below is full (all bits set), up to a single top level word. Finding a clear
+/// bit (acquire_free()) descends the summary levels, so it takes O(log64 N)
+/// steps regardless of how full the bitmap is.
+///
+/// The summary bits are maintained with fetch_or/fetch_and when words become
+/// full or non-full. A summary bit may briefly be stale while other threads
+/// are updating the same word, but it is repaired by the threads that observe
+/// the inconsistency.
+///
+/// @note This class requires C++11.
+class hierarchical_bitmap {
+public:
+  /// @brief The value returned by acquire_free() when all bits are set.
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  /// @brief Construct a bitmap with all bits cleared.
+  /// @param num_bits The number of bits (must be > 0).
+  explicit hierarchical_bitmap(const std::size_t num_bits)
+      : num_bits_(num_bits > 0u ? num_bits : 1u) {
+    std::size_t num_entries = num_bits_;
+    do {
+      const std::size_t num_words = (num_entries + BITS - 1u) / BITS;
+      level l;
+      l.num_words = num_words;
+      l.words.reset(new atomic<uint64_t>[num_words]);
+
+      // Bits that do not correspond to any entry are permanently set, so that
+      // they are never handed out (or make a word look non-full).
+      if ((num_entries % BITS) != 0u) {
+        l.words[num_words - 1u].store(FULL << (num_entries % BITS));
+      }
+      levels_.push_back(std::move(l));
+      num_entries = num_words;
+    } while (num_entries > 1u);
+  }
+
+  /// @returns the number of bits in the bitmap.
+  std::size_t size() const {
+    return num_bits_;
+  }
+
+  /// @returns the number of levels (including the bit level).
+  std::size_t num_levels() const {
+    return levels_.size();
+  }
+
+  /// @param pos The index of the bit.
+  /// @returns the value of the bit.
+  bool test(const std::size_t pos) const {
+    return (levels_[0].words[pos / BITS].load() & mask_for(pos)) != 0u;
+  }
+
+  /// @brief Atomically set a bit.
+  /// @param pos The index of the bit.
+  /// @returns the old value of the bit.
+  bool test_and_set(const std::size_t pos) {
+    const uint64_t mask = mask_for(pos);
+    const uint64_t old_word = levels_[0].words[pos / BITS].fetch_or(mask);
+    if ((old_word & mask) != 0u) {
+      return true;
+    }
+    if ((old_word | mask) == FULL) {
+      mark_full(1u, pos / BITS);
+    }
+    return false;
+  }
+
+  /// @brief Atomically clear a bit.
+  /// @param pos The index of the bit.
+  /// @returns the old value of the bit.
+  bool reset(const std::size_t pos) {
+    const uint64_t mask = mask_for(pos);
+    const uint64_t old_word = levels_[0].words[pos / BITS].fetch_and(~mask);
+    if (old_word == FULL) {
+      clear_full(1u, pos / BITS);
+    }
+    return (old_word & mask) != 0u;
+  }
+
+  /// @brief Find a clear bit and atomically set it.
+  ///
+  /// The search starts at a per-thread hint, so concurrent callers usually
+  /// operate on different words.
+  ///
+  /// @returns the index of the bit that was set, or npos if all bits are set.
+  /// @note If the bitmap is (nearly) full, this may return npos even though a
+  /// bit is concurrently being cleared by another thread.
+  std::size_t acquire_free() {
+    std::size_t& hint = detail::thread_hint();
+    std::size_t result;
+
+    // Fast path: Try the word where we last succeeded.
+    std::size_t word_idx = hint % levels_[0].num_words;
+    if (try_acquire_in_word(word_idx, hint, result)) {
+      return result;
+    }
+
+    const std::size_t top = levels_.size() - 1u;
+    for (;;) {
+      // Descend the summary levels to a word that has a clear bit.
+      word_idx = 0u;
+      std::size_t lvl = top;
+      for (; lvl > 0u; --lvl) {
+        const unsigned hint_bit =
+            static_cast<unsigned>((hint >> (6u * (lvl - 1u))) % BITS);
+        const unsigned bit =
+            find_clear_bit(levels_[lvl].words[word_idx].load(), hint_bit);
+        if (bit == BITS) {
+          break;
+        }
+        word_idx = word_idx * BITS + bit;
+      }
+
+      if (lvl == top && top > 0u) {
+        // The top level word is full, i.e. all bits are set.
+        return npos;
+      }
+      if (lvl > 0u) {
+        // A full word that is not yet marked as full in its parent level (a
+        // concurrent update is in progress): mark it and retry.
+        mark_full(lvl + 1u, word_idx);
+        continue;
+      }
+
+      if (try_acquire_in_word(word_idx, hint, result)) {
+        hint = word_idx;
+        return result;
+      }
+      if (top == 0u) {
+        return npos;
+      }
+
+      // The word turned out to be full: make sure that it is marked as such.
+      mark_full(1u, word_idx);
+    }
+  }
+
+  /// @returns the number of set bits.
+  /// @note The returned value may be outdated if other threads modify the
+  /// bitmap.
+  std::size_t count() const {
+    std::size_t result = 0u;
+    for (std::size_t w = 0; w < levels_[0].num_words; ++w) {
+      result += detail::population_count(levels_[0].words[w].load());
+    }
+    if ((num_bits_ % BITS) != 0u) {
+      result -= BITS - (num_bits_ % BITS);
+    }
+    return result;
+  }
+
+private:
+  static const unsigned BITS = 64u;
+  static const uint64_t FULL = ~static_cast<uint64_t>(0);
+
+  struct level {
+    std::size_t num_words;
+    std::unique_ptr<atomic<uint64_t>[]> words;
+  };
+
+  static uint64_t mask_for(const std::size_t pos) {
+    return static_cast<uint64_t>(1) << (pos % BITS);
+  }
+
+  // Find a clear bit in a word, preferring bits at or above preferred_bit.
+  // Returns BITS if there is no clear bit.
+  static unsigned find_clear_bit(const uint64_t word,
+                                 const unsigned preferred_bit) {
+    const uint64_t clear_bits = ~word;
+    if (clear_bits == 0u) {
+      return BITS;
+    }
+    const uint64_t preferred = clear_bits & (FULL << preferred_bit);
+    return detail::count_trailing_zeros(preferred != 0u ? preferred
+                                                         : clear_bits);
+  }
+
+  bool try_acquire_in_word(const std::size_t word_idx,
+                           const std::size_t hint,
+                           std::size_t& result) {
+    atomic<uint64_t>& w = levels_[0].words[word_idx];
+    uint64_t word = w.load();
+    while (word != FULL) {
+      const unsigned bit =
+          find_clear_bit(word, static_cast<unsigned>(hint % BITS));
+      const uint64_t mask = static_cast<uint64_t>(1) << bit;
+      const uint64_t old_word = w.fetch_or(mask);
+      if ((old_word & mask) == 0u) {
+        if ((old_word | mask) == FULL) {
+          mark_full(1u, word_idx);
+        }
+        result = word_idx * BITS + bit;
+        return true;
+      }
+
+      // Someone else got the bit first: retry with the fresh word.
+      word = old_word;
+    }
+    return false;
+  }
+
+  // Mark the word child_idx of level lvl - 1 as full in level lvl.
+  void mark_full(const std::size_t lvl, const std::size_t child_idx) {
+    if (lvl >= levels_.size()) {
+      return;
+    }
+    const std::size_t word_idx = child_idx / BITS;
+    const uint64_t mask = mask_for(child_idx);
+    const uint64_t old_word = levels_[lvl].words[word_idx].fetch_or(mask);
+
+    // The child may have been cleared after it became full, in which case the
+    // clearing thread may have missed our summary bit: undo it.
+    if (levels_[lvl - 1u].words[child_idx].load() != FULL) {
+      clear_full(lvl, child_idx);
+      return;
+    }
+
+    if ((old_word | mask) == FULL) {
+      mark_full(lvl + 1u, word_idx);
+    }
+  }
+
+  // Mark the word child_idx of level lvl - 1 as non-full in level lvl.
+  void clear_full(const std::size_t lvl, const std::size_t child_idx) {
+    if (lvl >= levels_.size()) {
+      return;
+    }
+    const std::size_t word_idx = child_idx / BITS;
+    const uint64_t old_word =
+        levels_[lvl].words[word_idx].fetch_and(~mask_for(child_idx));
+    if (old_word == FULL) {
+      clear_full(lvl + 1u, word_idx);
+    }
+  }
+
+  const std::size_t num_bits_;
+  std::vector<level> levels_;
+
+  ATOMIC_DISALLOW_COPY(hierarchical_bitmap)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_HIERARCHICAL_BITMAP_H_
@@ -0,0 +1,264 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_HISTOGRAM_H_
+#define ATOMIC_HISTOGRAM_H_
+
+#include "atomic/atomic.h"
+#include "atomic/bit_ops.h"
+#include "atomic/thread_hint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace atomic {
+/// @brief A point in time copy of the counts of a histogram.
+///
+/// The buckets use the same log-linear layout as the histogram that the
+/// snapshot was taken from.
+class histogram_snapshot {
+public:
+  /// @returns the total number of recorded values.
+  uint64_t count() const {
+    return total_;
+  }
+
+  /// @returns the number of buckets.
+  std::size_t num_buckets() const {
+    return counts_.size();
+  }
+
+  /// @param idx The bucket index.
+  /// @returns the number of values that were recorded in a bucket.
+  uint64_t bucket_count(const std::size_t idx) const {
+    return counts_[idx];
+  }
+
+  /// @param idx The bucket index.
+  /// @returns the smallest value that is recorded in a bucket.
+  uint64_t bucket_lower_bound(const std::size_t idx) const {
+    if (idx < sub_buckets_) {
+      return idx;
+    }
+    const std::size_t k = idx - sub_buckets_;
+    const unsigned shift = static_cast<unsigned>(k / sub_buckets_);
+    return (static_cast<uint64_t>(sub_buckets_ + k % sub_buckets_)) << shift;
+  }
+
+  /// @param idx The bucket index.
+  /// @returns the largest value that is recorded in a bucket.
+  uint64_t bucket_upper_bound(const std::size_t idx) const {
+    if (idx < sub_buckets_) {
+      return idx;
+    }
+    const unsigned shift =
+        static_cast<unsigned>((idx - sub_buckets_) / sub_buckets_);
+    return bucket_lower_bound(idx) + ((static_cast<uint64_t>(1) << shift) - 1u);
+  }
+
+  /// @brief Get the value at a given percentile.
+  ///
+  /// The result is the upper bound of the bucket that holds the value, so it
+  /// is never lower than the true value, and the relative error is bounded by
+  /// the precision of the histogram.
+  ///
+  /// @param percentile The percentile, in the range [0, 100].
+  /// @returns the value at the percentile, or zero if the snapshot is empty.
+  uint64_t value_at_percentile(const double percentile) const {
+    if (total_ == 0u) {
+      return 0u;
+    }
+    const double fraction =
+        (percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile)) /
+        100.0;
+    uint64_t target = static_cast<uint64_t>(fraction * total_ + 0.5);
+    if (target < 1u) {
+      target = 1u;
+    }
+    uint64_t accumulated = 0u;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      accumulated += counts_[i];
+      if (accumulated >= target) {
+        return bucket_upper_bound(i);
+      }
+    }
+    return max();
+  }
+
+  /// @returns the 50th percentile (the median).
+  uint64_t p50() const {
+    return value_at_percentile(50.0);
+  }
+
+  /// @returns the 99th percentile.
+  uint64_t p99() const {
+    return value_at_percentile(99.0);
+  }
+
+  /// @returns the 99.9th percentile.
+  uint64_t p999() const {
+    return value_at_percentile(99.9);
+  }
+
+  /// @returns the lower bound of the lowest non-empty bucket, or zero if the
+  /// snapshot is empty.
+  uint64_t min() const {
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      if (counts_[i] != 0u) {
+        return bucket_lower_bound(i);
+      }
+    }
+    return 0u;
+  }
+
+  /// @returns the upper bound of the highest non-empty bucket, or zero if the
+  /// snapshot is empty.
+  uint64_t max() const {
+    for (std::size_t i = counts_.size(); i > 0u; --i) {
+      if (counts_[i - 1u] != 0u) {
+        return bucket_upper_bound(i - 1u);
+      }
+    }
+    return 0u;
+  }
+
+private:
+  friend class histogram;
+
+  histogram_snapshot(const std::size_t sub_buckets,
+                     const std::size_t num_buckets)
+      : sub_buckets_(sub_buckets), counts_(num_buckets, 0u), total_(0u) {}
+
+  std::size_t sub_buckets_;
+  std::vector<uint64_t> counts_;
+  uint64_t total_;
+};
+
+/// @brief A lock-free histogram of 64-bit unsigned values (e.g. latencies).
+///
+/// Values are counted in log-linear buckets (like HdrHistogram): each power of
+/// two range is divided into 2^precision_bits linear sub-buckets, which bounds
+/// the relative error to 2^-precision_bits. Values below 2^precision_bits are
+/// counted exactly.
+///
+/// The counters are sharded (each shard is a separate set of cache lines), and
+/// each thread records into its own shard, so recording a value is a single
+/// relaxed fetch_add that rarely contends with other threads. snapshot() sums
+/// up the shards.
+///
+/// @note This class requires C++11.
+class histogram {
+public:
+  /// @brief Construct a histogram.
+  /// @param precision_bits The number of linear sub-bucket bits (1 to 16).
+  /// @param num_shards The number of shards (typically in the order of the
+  /// number of concurrently recording threads).
+  explicit histogram(const unsigned precision_bits = 5,
+                     const std::size_t num_shards = 8)
+      : precision_bits_(precision_bits < 1u
+                            ? 1u
+                            : (precision_bits > 16u ? 16u : precision_bits)),
+        sub_buckets_(static_cast<std::size_t>(1) << precision_bits_),
+        num_buckets_(sub_buckets_ * (65u - precision_bits_)),
+        shard_stride_(round_up_to_cache_line(num_buckets_)),
+        num_shards_(num_shards > 0u ? num_shards : 1u),
+        counts_(new atomic<uint64_t>[shard_stride_ * num_shards_]) {}
+
+  /// @brief Record a value.
+  /// @param value The value.
+  /// @param count The number of times to record the value.
+  void record(const uint64_t value, const uint64_t count = 1u) {
+    const std::size_t shard = detail::thread_index() % num_shards_;
+    counts_[shard * shard_stride_ + bucket_index(value)].fetch_add(
+        count, memory_order_relaxed);
+  }
+
+  /// @brief Take a snapshot of the histogram.
+  ///
+  /// Values that are recorded concurrently with the snapshot may or may not
+  /// be included in the snapshot.
+  ///
+  /// @returns the snapshot.
+  histogram_snapshot snapshot() const {
+    histogram_snapshot result(sub_buckets_, num_buckets_);
+    for (std::size_t s = 0; s < num_shards_; ++s) {
+      const atomic<uint64_t>* shard = &counts_[s * shard_stride_];
+      for (std::size_t i = 0; i < num_buckets_; ++i) {
+        result.counts_[i] += shard[i].load(memory_order_relaxed);
+      }
+    }
+    for (std::size_t i = 0; i < num_buckets_; ++i) {
+      result.total_ += result.counts_[i];
+    }
+    return result;
+  }
+
+  /// @brief Clear all the counts.
+  /// @note Values that are recorded concurrently may be lost.
+  void reset() {
+    for (std::size_t i = 0; i < shard_stride_ * num_shards_; ++i) {
+      counts_[i].store(0u, memory_order_relaxed);
+    }
+  }
+
+  /// @returns the number of buckets.
+  std::size_t num_buckets() const {
+    return num_buckets_;
+  }
+
+  /// @param value A value.
+  /// @returns the index of the bucket that the value is recorded in.
+  std::size_t bucket_index(const uint64_t value) const {
+    if (value < sub_buckets_) {
+      return static_cast<std::size_t>(value);
+    }
+    const unsigned shift =
+        detail::most_significant_bit(value) - precision_bits_;
+    return sub_buckets_ * (shift + 1u) +
+           static_cast<std::size_t>((value >> shift) - sub_buckets_);
+  }
+
+private:
+  // Note: An extra cache line is added between shards, since the array is not
+  // necessarily cache line aligned.
+  static std::size_t round_up_to_cache_line(const std::size_t num_counters) {
+    const std::size_t per_line = ATOMIC_CACHE_LINE_SIZE / sizeof(uint64_t);
+    return ((num_counters + per_line - 1u) / per_line + 1u) * per_line;
+  }
+
+  const unsigned precision_bits_;
+  const std::size_t sub_buckets_;
+  const std::size_t num_buckets_;
+  const std::size_t shard_stride_;
+  const std::size_t num_shards_;
+  std::unique_ptr<atomic<uint64_t>[]> counts_;
+
+  ATOMIC_DISALLOW_COPY(histogram)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_HISTOGRAM_H_
@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_LATCH_H_
+#define ATOMIC_LATCH_H_
+
+#include "atomic/atomic.h"
+#include "atomic/wait.h"
+
+namespace atomic {
+/// @brief A single use countdown latch.
+///
+/// Threads decrement the counter with count_down(), and threads that call
+/// wait() block until the counter has reached zero. Waiting threads spin for a
+/// short while before they are put to sleep (using a futex on Linux).
+class latch {
+public:
+  /// @brief Construct a latch.
+  /// @param count The initial value of the counter.
+  explicit latch(const int count) : count_(count), waiters_(0) {}
+
+  /// @brief Decrement the counter.
+  ///
+  /// If the counter reaches zero, all waiting threads are woken up.
+  ///
+  /// @param n The value to subtract from the counter.
+  void count_down(const int n = 1) {
+    if (count_.fetch_sub(n) == n && waiters_.load() != 0) {
+      detail::wake_all_by_address(count_);
+    }
+  }
+
+  /// @returns true if the counter has reached zero.
+  bool try_wait() const {
+    return count_.load() == 0;
+  }
+
+  /// @brief Block until the counter has reached zero.
+  void wait() {
+    for (int i = 0; i < SPIN_COUNT; ++i) {
+      if (count_.load() == 0) {
+        return;
+      }
+      detail::cpu_relax();
+    }
+
+    // Note: The waiter count is incremented before the counter is checked, so
+    // a thread that brings the counter to zero is guaranteed to see it.
+    ++waiters_;
+    for (int count = count_.load(); count != 0; count = count_.load()) {
+      detail::wait_on_address(count_, count);
+    }
+    --waiters_;
+  }
+
+  /// @brief Decrement the counter and block until it has reached zero.
+  /// @param n The value to subtract from the counter.
+  void arrive_and_wait(const int n = 1) {
+    count_down(n);
+    wait();
+  }
+
+private:
+  static const int SPIN_COUNT = 1000;
+
+  atomic<int> count_;
+  atomic<int> waiters_;
+
+  ATOMIC_DISALLOW_COPY(latch)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_LATCH_H_
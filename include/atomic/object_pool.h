@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_OBJECT_POOL_H_
+#define ATOMIC_OBJECT_POOL_H_
+
+#include "atomic/atomic.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace atomic {
+/// @brief A fixed size, lock-free object pool.
+///
+/// All the objects are allocated from an arena that is allocated up front.
+/// Free slots are kept in a lock-free free list (a Treiber stack with a tagged
+/// head, to avoid the ABA problem).
+///
+/// For the best performance, each thread should use a magazine, which is a
+/// small thread local cache of free slots. A magazine only touches the shared
+/// free list when it needs to be refilled or flushed, and then it moves a
+/// batch of slots at a time.
+///
+/// @tparam T The object type.
+/// @tparam MagazineSize The maximum number of free slots held by a magazine.
+/// @note This class requires C++11.
+template <typename T, std::size_t MagazineSize = 32>
+class object_pool {
+public:
+  /// @brief Construct a pool.
+  /// @param capacity The maximum number of live objects.
+  /// @throws std::length_error if @c capacity is 2^32 - 1 or more (slots
+  /// are indexed by 32-bit integers).
+  explicit object_pool(const std::size_t capacity)
+      : capacity_(checked_capacity(capacity)),
+        storage_(new storage_type[capacity_]),
+        next_(new atomic<uint32_t>[capacity_]) {
+    // Initially all the slots are in the free list.
+    for (uint32_t i = 0; i + 1u < capacity_; ++i) {
+      next_[i].store(i + 1u);
+    }
+    if (capacity_ > 0u) {
+      next_[capacity_ - 1u].store(NIL);
+      head_.store(make_head(0u, 0u));
+    } else {
+      head_.store(make_head(0u, NIL));
+    }
+  }
+
+  /// @brief Destroy the pool.
+  /// @note All objects must have been destroyed before the pool is destroyed.
+  ~object_pool() {}
+
+  /// @returns the maximum number of live objects.
+  std::size_t capacity() const {
+    return capacity_;
+  }
+
+  /// @brief Create a new object.
+  /// @param args The arguments that are passed to the constructor of T.
+  /// @returns a pointer to the new object, or nullptr if the pool is empty.
+  template <typename... Args>
+  T* create(Args&&... args) {
+    uint32_t slot;
+    if (pop_chain(1u, slot) == 0u) {
+      return nullptr;
+    }
+    return construct_at(slot, std::forward<Args>(args)...);
+  }
+
+  /// @brief Destroy an object that was created by this pool.
+  /// @param obj The object.
+  void destroy(T* obj) {
+    obj->~T();
+    const uint32_t slot = slot_of(obj);
+    push_chain(slot, slot);
+  }
+
+  /// @brief A per-thread cache of free slots.
+  ///
+  /// A magazine must only be used by one thread at a time. Objects may be
+  /// destroyed through any magazine of the same pool (or the pool itself),
+  /// regardless of which magazine created them.
+  class magazine {
+  public:
+    /// @brief Construct an (empty) magazine.
+    /// @param pool The pool that the magazine allocates from.
+    explicit magazine(object_pool& pool) : pool_(pool), count_(0u) {}
+
+    /// @brief The destructor returns all cached slots to the pool.
+    ~magazine() {
+      flush();
+    }
+
+    /// @brief Create a new object.
+    /// @param args The arguments that are passed to the constructor of T.
+    /// @returns a pointer to the new object, or nullptr if the pool is empty.
+    template <typename... Args>
+    T* create(Args&&... args) {
+      if (count_ == 0u) {
+        refill();
+        if (count_ == 0u) {
+          return nullptr;
+        }
+      }
+      const uint32_t slot = slots_[--count_];
+      return pool_.construct_at(slot, std::forward<Args>(args)...);
+    }
+
+    /// @brief Destroy an object that was created by the same pool.
+    /// @param obj The object.
+    void destroy(T* obj) {
+      obj->~T();
+      if (count_ == MagazineSize) {
+        flush(BATCH_SIZE);
+      }
+      slots_[count_++] = pool_.slot_of(obj);
+    }
+
+    /// @brief Return all cached slots to the pool.
+    void flush() {
+      flush(count_);
+    }
+
+  private:
+    static const std::size_t BATCH_SIZE = (MagazineSize + 1u) / 2u;
+
+    void refill() {
+      uint32_t slot;
+      const std::size_t count = pool_.pop_chain(BATCH_SIZE, slot);
+      for (std::size_t i = 0; i < count; ++i) {
+        slots_[count_++] = slot;
+        slot = pool_.next_[slot].load();
+      }
+    }
+
+    // Return the n most recently freed slots to the pool (as a single chain).
+    void flush(const std::size_t n) {
+      if (n == 0u) {
+        return;
+      }
+      const std::size_t first = count_ - n;
+      for (std::size_t i = first; i + 1u < count_; ++i) {
+        pool_.next_[slots_[i]].store(slots_[i + 1u]);
+      }
+      pool_.push_chain(slots_[first], slots_[count_ - 1u]);
+      count_ = first;
+    }
+
+    object_pool& pool_;
+    std::size_t count_;
+    uint32_t slots_[MagazineSize];
+
+    ATOMIC_DISALLOW_COPY(magazine)
+  };
+
+private:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type
+      storage_type;
+
+  ATOMIC_STATIC_ASSERT(MagazineSize > 0u, "The magazine size must be > 0");
+
+  // The head of the free list holds a tag in the upper 32 bits and a slot index
+  // in the lower 32 bits. The tag is incremented by every update.
+  static const uint32_t NIL = 0xffffffffu;
+
+  static uint32_t checked_capacity(const std::size_t capacity) {
+    // The index NIL is reserved for the list terminator.
+    if (capacity >= NIL) {
+      throw std::length_error("object_pool: The capacity is too large");
+    }
+    return static_cast<uint32_t>(capacity);
+  }
+
+  static uint64_t make_head(const uint32_t tag, const uint32_t slot) {
+    return (static_cast<uint64_t>(tag) << 32) | static_cast<uint64_t>(slot);
+  }
+
+  static uint32_t tag_of_head(const uint64_t head) {
+    return static_cast<uint32_t>(head >> 32);
+  }
+
+  static uint32_t slot_of_head(const uint64_t head) {
+    return static_cast<uint32_t>(head);
+  }
+
+  uint32_t slot_of(const T* obj) const {
+    return static_cast<uint32_t>(reinterpret_cast<const storage_type*>(obj) -
+                                 storage_.get());
+  }
+
+  template <typename... Args>
+  T* construct_at(const uint32_t slot, Args&&... args) {
+    struct slot_guard {
+      object_pool* pool;
+      uint32_t slot;
+      ~slot_guard() {
+        if (pool != nullptr) {
+          pool->push_chain(slot, slot);
+        }
+      }
+    } guard = {this, slot};
+
+    // If the constructor throws, the guard returns the slot to the free list.
+    T* obj = new (&storage_[slot]) T(std::forward<Args>(args)...);
+    guard.pool = nullptr;
+    return obj;
+  }
+
+  // Push the chain first -> ... -> last onto the free list. The chain must
+  // already be linked via next_.
+  void push_chain(const uint32_t first, const uint32_t last) {
+    uint64_t old_head = head_.load();
+    for (;;) {
+      next_[last].store(slot_of_head(old_head));
+      const uint64_t new_head = make_head(tag_of_head(old_head) + 1u, first);
+      if (head_.compare_exchange_weak(old_head, new_head)) {
+        return;
+      }
+    }
+  }
+
+  // Pop a chain of up to max_count slots from the free list. The chain is
+  // linked via next_, and starts at first.
+  // Note: Walking the chain before the CAS is safe, since any concurrent
+  // change of the free list updates the tag and makes the CAS fail.
+  std::size_t pop_chain(const std::size_t max_count, uint32_t& first) {
+    uint64_t old_head = head_.load();
+    for (;;) {
+      first = slot_of_head(old_head);
+      std::size_t count = 0u;
+      uint32_t next = first;
+      while (next != NIL && count < max_count) {
+        next = next_[next].load();
+        ++count;
+      }
+      if (count == 0u) {
+        return 0u;
+      }
+      const uint64_t new_head = make_head(tag_of_head(old_head) + 1u, next);
+      if (head_.compare_exchange_weak(old_head, new_head)) {
+        return count;
+      }
+    }
+  }
+
+  const uint32_t capacity_;
+  std::unique_ptr<storage_type[]> storage_;
+  std::unique_ptr<atomic<uint32_t>[]> next_;
+  atomic<uint64_t> head_;
+
+  ATOMIC_DISALLOW_COPY(object_pool)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_OBJECT_POOL_H_
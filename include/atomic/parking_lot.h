@@ -0,0 +1,375 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_PARKING_LOT_H_
+#define ATOMIC_PARKING_LOT_H_
+
+#include "atomic/atomic.h"
+#include "atomic/spinlock.h"
+#include "atomic/wait.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace atomic {
+namespace detail {
+/// @brief A thread that is parked in the parking lot.
+///
+/// The waiter lives on the stack of the parked thread, which must not return
+/// from park() while an unparking thread may still access the waiter. Hence
+/// the unparking thread sets the state to WOKEN when it is done with the
+/// waiter, and the parked thread waits for that state.
+struct parking_waiter {
+  /// @brief The states of a waiter.
+  enum {
+    PARKED = 0,    ///< Parked (or in the process of parking).
+    SIGNALED = 1,  ///< Unparked, but the unparking thread is still busy.
+    WOKEN = 2      ///< Unparked, and the waiter is no longer accessed.
+  };
+
+  parking_waiter() : address(0), next(0), state(PARKED) {}
+
+  const void* address;   // Protected by the bucket lock.
+  parking_waiter* next;  // Protected by the bucket lock.
+  atomic<int> state;
+
+  ATOMIC_DISALLOW_COPY(parking_waiter)
+};
+
+/// @brief A queue of the waiters whose addresses hash to the same bucket.
+struct parking_bucket {
+  ATOMIC_CONSTEXPR parking_bucket() : head(0), tail(0), padding() {}
+
+  void enqueue(parking_waiter* waiter) {
+    waiter->next = 0;
+    if (tail != 0) {
+      tail->next = waiter;
+    } else {
+      head = waiter;
+    }
+    tail = waiter;
+  }
+
+  /// @brief Remove the first waiter that is parked on an address.
+  /// @param address The address.
+  /// @param[out] have_more Set to true if more waiters are parked on the
+  /// address.
+  /// @returns the waiter, or null if no waiter is parked on the address.
+  parking_waiter* dequeue_first(const void* address, bool& have_more) {
+    parking_waiter* result = 0;
+    parking_waiter* prev = 0;
+    parking_waiter* w = head;
+    have_more = false;
+    while (w != 0) {
+      if (w->address == address) {
+        if (result != 0) {
+          have_more = true;
+          break;
+        }
+        result = w;
+        w = w->next;
+        unlink(prev, result);
+      } else {
+        prev = w;
+        w = w->next;
+      }
+    }
+    return result;
+  }
+
+  /// @brief Remove a given waiter.
+  /// @returns true if the waiter was in the queue.
+  bool remove(parking_waiter* waiter) {
+    parking_waiter* prev = 0;
+    for (parking_waiter* w = head; w != 0; prev = w, w = w->next) {
+      if (w == waiter) {
+        unlink(prev, w);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void unlink(parking_waiter* prev, parking_waiter* w) {
+    if (prev != 0) {
+      prev->next = w->next;
+    } else {
+      head = w->next;
+    }
+    if (tail == w) {
+      tail = prev;
+    }
+  }
+
+  // The bucket lock is only held for a few instructions, but there may be
+  // more threads than CPUs, so contended lockers back off (and yield).
+  void lock() {
+    spin_backoff backoff;
+    while (!mutex.try_lock()) {
+      backoff.pause();
+    }
+  }
+
+  void unlock() {
+    mutex.unlock();
+  }
+
+  byte_spinlock mutex;
+  parking_waiter* head;  // Protected by mutex.
+  parking_waiter* tail;  // Protected by mutex.
+  char padding[ATOMIC_CACHE_LINE_SIZE];
+};
+}  // namespace detail
+
+/// @brief A global table of queues of parked (sleeping) threads, keyed by
+/// address.
+///
+/// Blocking primitives (mutexes, condition variables, once flags, etc) can use
+/// the parking lot for their waiting threads instead of embedding a queue, so
+/// that the primitive itself only needs a few bits (e.g. "locked" and "has
+/// parked threads" bits in an atomic<uint8_t>). The design follows the parking
+/// lot of WebKit.
+///
+/// The addresses are hashed to a fixed number of buckets, each with its own
+/// lock and queue, so there is no per-object overhead, and unrelated
+/// addresses rarely contend.
+///
+/// @note This class requires C++11.
+class parking_lot {
+public:
+  /// @brief The result of park().
+  enum class park_result {
+    unparked,  ///< The thread was unparked by unpark_one() or unpark_all().
+    invalid,   ///< The validation failed, so the thread was never parked.
+    timed_out  ///< The timeout expired before the thread was unparked.
+  };
+
+  /// @brief The information that is passed to the unpark_one() callback.
+  struct unpark_result {
+    /// @brief True if a thread was unparked.
+    bool did_unpark_thread;
+
+    /// @brief True if more threads are parked on the address.
+    bool have_more_threads;
+  };
+
+  /// @brief Park the calling thread on an address, until it is unparked.
+  ///
+  /// @c validate is called while holding the lock of the queue that the
+  /// thread would be parked in. If it returns false, the thread is not
+  /// parked. Since unpark_one() and unpark_all() take the same lock, no
+  /// unpark can happen between the validation and the parking (e.g. validate
+  /// typically checks that a lock is still held).
+  ///
+  /// @param address The address to park on (it is never dereferenced).
+  /// @param validate A callable that returns true if the thread should park.
+  /// @returns the reason for returning.
+  /// @note @c validate must not call any of the parking_lot functions.
+  template <typename Validate>
+  static park_result park(const void* address, Validate validate) {
+    return park_until(address, validate, false, clock::time_point());
+  }
+
+  /// @brief Park the calling thread on an address, until it is unparked or a
+  /// timeout has expired.
+  /// @param address The address to park on (it is never dereferenced).
+  /// @param validate A callable that returns true if the thread should park.
+  /// @param timeout The maximum duration to be parked.
+  /// @returns the reason for returning.
+  template <typename Validate, typename Rep, typename Period>
+  static park_result park(const void* address,
+                          Validate validate,
+                          const std::chrono::duration<Rep, Period>& timeout) {
+    return park_until(address,
+                      validate,
+                      true,
+                      clock::now() +
+                          std::chrono::duration_cast<clock::duration>(timeout));
+  }
+
+  /// @brief Unpark one of the threads that are parked on an address (the one
+  /// that has been parked the longest).
+  ///
+  /// @c callback is called with an unpark_result while holding the lock of
+  /// the queue, before the thread is woken up. This makes it possible to
+  /// update the state of a primitive atomically with respect to threads that
+  /// are about to park (e.g. to clear a "has parked threads" bit when the
+  /// last thread is unparked).
+  ///
+  /// @param address The address.
+  /// @param callback A callable that takes an unpark_result.
+  /// @note @c callback must not call any of the parking_lot functions.
+  template <typename Callback>
+  static void unpark_one(const void* address, Callback callback) {
+    detail::parking_bucket& bucket = bucket_for(address);
+    detail::parking_waiter* waiter;
+    {
+      basic_lock_guard<detail::parking_bucket> guard(bucket);
+      unpark_result result;
+      waiter = bucket.dequeue_first(address, result.have_more_threads);
+      result.did_unpark_thread = (waiter != 0);
+      callback(result);
+    }
+    if (waiter != 0) {
+      wake(waiter);
+    }
+  }
+
+  /// @brief Unpark one of the threads that are parked on an address.
+  /// @param address The address.
+  /// @returns true if a thread was unparked.
+  static bool unpark_one(const void* address) {
+    bool did_unpark = false;
+    unpark_one(address, [&did_unpark](const unpark_result& result) {
+      did_unpark = result.did_unpark_thread;
+    });
+    return did_unpark;
+  }
+
+  /// @brief Unpark all the threads that are parked on an address.
+  /// @param address The address.
+  /// @returns the number of threads that were unparked.
+  static std::size_t unpark_all(const void* address) {
+    detail::parking_bucket& bucket = bucket_for(address);
+
+    // Move the waiters to a private list (linked by their next pointers).
+    detail::parking_waiter* first = 0;
+    detail::parking_waiter* last = 0;
+    {
+      basic_lock_guard<detail::parking_bucket> guard(bucket);
+      bool have_more = true;
+      while (have_more) {
+        detail::parking_waiter* w = bucket.dequeue_first(address, have_more);
+        if (w == 0) {
+          break;
+        }
+        w->next = 0;
+        if (last != 0) {
+          last->next = w;
+        } else {
+          first = w;
+        }
+        last = w;
+      }
+    }
+
+    // Note: A woken thread may return from park() (and destroy its waiter)
+    // right away, so the next pointer is read before waking the thread.
+    std::size_t count = 0u;
+    while (first != 0) {
+      detail::parking_waiter* next = first->next;
+      wake(first);
+      first = next;
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  typedef std::chrono::steady_clock clock;
+
+  // The number of buckets (a power of two).
+  static const std::size_t NUM_BUCKETS = 1024u;
+
+  static detail::parking_bucket& bucket_for(const void* address) {
+    // Note: The buckets are constant-initialized.
+    static detail::parking_bucket s_buckets[NUM_BUCKETS];
+
+    // Fibonacci hashing of the address (the low bits are mostly zero).
+    const uint64_t x = static_cast<uint64_t>(
+        reinterpret_cast<uintptr_t>(address));
+    const uint64_t hash = (x * UINT64_C(0x9e3779b97f4a7c15)) >> 32;
+    return s_buckets[hash & (NUM_BUCKETS - 1u)];
+  }
+
+  template <typename Validate>
+  static park_result park_until(const void* address,
+                                Validate& validate,
+                                const bool has_deadline,
+                                const clock::time_point deadline) {
+    detail::parking_waiter me;
+    detail::parking_bucket& bucket = bucket_for(address);
+    {
+      basic_lock_guard<detail::parking_bucket> guard(bucket);
+      if (!validate()) {
+        return park_result::invalid;
+      }
+      me.address = address;
+      bucket.enqueue(&me);
+    }
+
+    if (has_deadline) {
+      while (me.state.load(memory_order_acquire) ==
+             detail::parking_waiter::PARKED) {
+        const clock::time_point now = clock::now();
+        if (now >= deadline) {
+          break;
+        }
+        const long long timeout_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(deadline -
+                                                                 now)
+                .count();
+        detail::wait_on_address_for(
+            me.state, detail::parking_waiter::PARKED, timeout_ns);
+      }
+      if (me.state.load(memory_order_acquire) ==
+          detail::parking_waiter::PARKED) {
+        basic_lock_guard<detail::parking_bucket> guard(bucket);
+        if (bucket.remove(&me)) {
+          return park_result::timed_out;
+        }
+        // We were dequeued by an unpark that has not woken us up yet, so we
+        // must wait for it (it is imminent).
+      }
+    }
+
+    while (me.state.load(memory_order_acquire) ==
+           detail::parking_waiter::PARKED) {
+      detail::wait_on_address(me.state, detail::parking_waiter::PARKED);
+    }
+
+    // The unparking thread is about to stop accessing the waiter (it only
+    // has to return from the wake up system call).
+    detail::spin_backoff backoff;
+    while (me.state.load(memory_order_acquire) !=
+           detail::parking_waiter::WOKEN) {
+      backoff.pause();
+    }
+    return park_result::unparked;
+  }
+
+  static void wake(detail::parking_waiter* waiter) {
+    waiter->state.store(detail::parking_waiter::SIGNALED,
+                        memory_order_release);
+    detail::wake_by_address(waiter->state, 1);
+    // Note: This is the last access to the waiter.
+    waiter->state.store(detail::parking_waiter::WOKEN, memory_order_release);
+  }
+
+  parking_lot();
+};
+}  // namespace atomic
+
+#endif  // ATOMIC_PARKING_LOT_H_
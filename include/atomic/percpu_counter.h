@@ -0,0 +1,345 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_PERCPU_COUNTER_H_
+#define ATOMIC_PERCPU_COUNTER_H_
+
+#include "atomic/atomic.h"
+#include "atomic/atomic_ref.h"
+#include "atomic/thread_hint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Per-CPU updates use Linux restartable sequences (rseq), which are currently
+// implemented for x86-64. Define ATOMIC_NO_RSEQ to always use the fallback.
+#if defined(__GNUC__) && defined(__linux__) && defined(__x86_64__) && \
+    !defined(ATOMIC_NO_RSEQ)
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_rseq)
+#define ATOMIC_PERCPU_USE_RSEQ
+#endif
+#endif
+
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+// The rseq area that the C library (glibc 2.35 and later) registers for each
+// thread. The symbols are weak, so that we can fall back to registering our
+// own area when they are missing.
+extern "C" {
+extern const ptrdiff_t __rseq_offset __attribute__((weak));
+extern const unsigned int __rseq_size __attribute__((weak));
+}
+#elif defined(__linux__)
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+namespace atomic {
+namespace detail {
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+namespace rseq {
+// The start of struct rseq (see linux/rseq.h).
+struct area {
+  uint32_t cpu_id_start;
+  uint32_t cpu_id;
+  uint64_t rseq_cs;
+  uint32_t flags;
+  uint32_t padding[3];
+} __attribute__((aligned(32)));
+
+// The signature that precedes the abort handler (the same as glibc uses, which
+// is required when using the area of the C library).
+const uint32_t SIGNATURE = 0x53053053u;
+
+// The cached rseq area of a thread. It is trivially destructible, so it stays
+// valid while the other thread_local objects of the thread are destroyed.
+struct thread_state {
+  area* ptr;
+  bool initialized;
+};
+
+inline thread_state& this_thread_state() {
+  static thread_local thread_state s_state = {0, false};
+  return s_state;
+}
+
+// A registration of an rseq area that is owned by us (used when the C library
+// has not registered an area for the thread). The area must be unregistered
+// before the thread exits, since the kernel writes to it. After that, the
+// thread uses the fallback path (e.g. in the destructors of other thread_local
+// objects).
+class registration {
+public:
+  registration() : registered_(false) {
+    area_.cpu_id_start = 0u;
+    area_.cpu_id = ~static_cast<uint32_t>(0);
+    area_.rseq_cs = 0u;
+    area_.flags = 0u;
+    registered_ =
+        syscall(SYS_rseq, &area_, sizeof(area_), 0, SIGNATURE) == 0;
+  }
+
+  ~registration() {
+    if (registered_) {
+      // Note: 1 = RSEQ_FLAG_UNREGISTER.
+      syscall(SYS_rseq, &area_, sizeof(area_), 1, SIGNATURE);
+      registered_ = false;
+    }
+
+    // Mark rseq as unavailable, so that the area is never used again.
+    thread_state& state = this_thread_state();
+    state.ptr = 0;
+    state.initialized = true;
+  }
+
+  area* get() {
+    return registered_ ? &area_ : static_cast<area*>(0);
+  }
+
+private:
+  area area_;
+  bool registered_;
+
+  ATOMIC_DISALLOW_COPY(registration)
+};
+
+// Find (or create) the rseq area of the calling thread.
+inline area* register_thread() {
+  area* result;
+  if (&__rseq_size != 0 && __rseq_size != 0u) {
+    // The area is at a fixed offset from the thread pointer (which is stored
+    // at %fs:0 on x86-64).
+    char* thread_pointer;
+    __asm__("movq %%fs:0, %0" : "=r"(thread_pointer));
+    result = reinterpret_cast<area*>(thread_pointer + __rseq_offset);
+  } else {
+    static thread_local registration s_registration;
+    result = s_registration.get();
+  }
+
+  // The kernel sets the CPU number when the area is registered.
+  const volatile area* a = result;
+  if (result != 0 && static_cast<int32_t>(a->cpu_id) < 0) {
+    result = 0;
+  }
+  return result;
+}
+
+/// @returns the rseq area of the calling thread, or null if restartable
+/// sequences are not available.
+inline area* thread_area() {
+  thread_state& state = this_thread_state();
+  if (!state.initialized) {
+    state.ptr = register_thread();
+    state.initialized = true;
+  }
+  return state.ptr;
+}
+
+/// @brief Add a value to a per-CPU variable in a restartable sequence.
+///
+/// The addition is a plain (non-atomic) read-modify-write instruction, which
+/// is only committed if the thread is still running on CPU @c cpu, and is not
+/// preempted or interrupted by a signal before the instruction.
+///
+/// @param a The rseq area of the calling thread.
+/// @param cpu The CPU that the variable belongs to.
+/// @param v The variable.
+/// @param x The value to add.
+/// @returns false if the sequence was aborted (and nothing was written).
+///
+/// @note The descriptor and the abort handler are placed in the section group
+/// ("?") of the function, since the function may be emitted in several
+/// translation units, and the linker must discard all the sections of the
+/// duplicates together.
+template <typename T>
+inline bool add(area* a, const uint32_t cpu, T* v, const T x) {
+  __asm__ __volatile__ goto(
+      // The critical section descriptor (struct rseq_cs).
+      ".pushsection __rseq_cs, \"aw?\"\n\t"
+      ".balign 32\n\t"
+      "3:\n\t"
+      ".long 0x0, 0x0\n\t"
+      ".quad 1f, (2f - 1f), 4f\n\t"
+      ".popsection\n\t"
+
+      // Enter the critical section.
+      "leaq 3b(%%rip), %%rax\n\t"
+      "movq %%rax, 8(%[area])\n\t"
+      "1:\n\t"
+      "cmpl %[cpu], 4(%[area])\n\t"
+      "jnz 4f\n\t"
+
+      // The commit.
+      "add%z[v] %[x], %[v]\n\t"
+      "2:\n\t"
+
+      // The abort handler (preceded by the signature).
+      ".pushsection __rseq_failure, \"ax?\"\n\t"
+      ".byte 0x0f, 0xb9, 0x3d\n\t"
+      ".long %c[signature]\n\t"
+      "4:\n\t"
+      "jmp %l[aborted]\n\t"
+      ".popsection\n\t"
+      :
+      : [area] "r"(a),
+        [cpu] "r"(cpu),
+        [v] "m"(*v),
+        [x] "r"(x),
+        [signature] "i"(SIGNATURE)
+      : "rax", "memory", "cc"
+      : aborted);
+  return true;
+aborted:
+  return false;
+}
+}  // namespace rseq
+#endif  // ATOMIC_PERCPU_USE_RSEQ
+
+/// @returns the number of CPUs that are configured in the system.
+inline std::size_t num_configured_cpus() {
+#if defined(__linux__)
+  const long count = sysconf(_SC_NPROCESSORS_CONF);
+#else
+  const long count = static_cast<long>(std::thread::hardware_concurrency());
+#endif
+  return count > 0 ? static_cast<std::size_t>(count) : 1u;
+}
+}  // namespace detail
+
+/// @brief A counter that is optimized for frequent updates and rare reads.
+///
+/// The counter keeps one slot (on a separate cache line) per CPU. On Linux
+/// (x86-64), add() updates the slot of the current CPU with a plain add
+/// instruction in a restartable sequence (rseq), so no locked instruction is
+/// needed and threads on different CPUs never share cache lines. If
+/// restartable sequences are not available, each thread instead does a
+/// relaxed fetch_add on a slot that is selected by the thread index (like
+/// the shards of a histogram).
+///
+/// sum() adds up all the slots, so reading the counter is relatively costly.
+///
+/// @tparam T An integer type.
+/// @note This class requires C++11.
+template <typename T>
+class percpu_counter {
+public:
+  ATOMIC_STATIC_ASSERT(detail::is_integral<T>::value,
+                       "percpu_counter requires an integer type");
+
+  /// @brief Construct a counter with the value zero.
+  percpu_counter()
+      : num_slots_(detail::num_configured_cpus()),
+        slots_(new slot[num_slots_]()) {}
+
+  /// @brief Add a value to the counter.
+  /// @param x The value to add.
+  void add(const T x) {
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+    detail::rseq::area* const a = detail::rseq::thread_area();
+    if (a != 0) {
+      const volatile detail::rseq::area* va = a;
+      for (;;) {
+        const uint32_t cpu = va->cpu_id;
+        if (cpu >= num_slots_) {
+          break;
+        }
+        if (detail::rseq::add(a, cpu, &slots_[cpu].percpu, x)) {
+          return;
+        }
+      }
+    }
+#endif
+    slots_[detail::thread_index() % num_slots_].shared.fetch_add(
+        x, memory_order_relaxed);
+  }
+
+  /// @brief Subtract a value from the counter.
+  /// @param x The value to subtract.
+  void sub(const T x) {
+    add(static_cast<T>(T(0) - x));
+  }
+
+  /// @brief Get the value of the counter.
+  ///
+  /// Updates that happen concurrently with the call may or may not be
+  /// included in the result.
+  ///
+  /// @returns the sum of all the slots.
+  T sum() const {
+    T result = T(0);
+    for (std::size_t i = 0; i < num_slots_; ++i) {
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+      result = static_cast<T>(
+          result + atomic_ref<T>(slots_[i].percpu).load(memory_order_relaxed));
+#endif
+      result = static_cast<T>(
+          result + slots_[i].shared.load(memory_order_relaxed));
+    }
+    return result;
+  }
+
+  /// @brief Set the counter to zero.
+  /// @note Updates that happen concurrently may be lost.
+  void reset() {
+    for (std::size_t i = 0; i < num_slots_; ++i) {
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+      atomic_ref<T>(slots_[i].percpu).store(T(0), memory_order_relaxed);
+#endif
+      slots_[i].shared.store(T(0), memory_order_relaxed);
+    }
+  }
+
+  /// @returns true if add() uses restartable sequences in the calling thread.
+  static bool uses_rseq() {
+#if defined(ATOMIC_PERCPU_USE_RSEQ)
+    return detail::rseq::thread_area() != 0;
+#else
+    return false;
+#endif
+  }
+
+private:
+  // Note: The slots are not necessarily cache line aligned, but each slot
+  // is a full cache line, so the counters of two slots never share a cache
+  // line.
+  struct slot {
+    T percpu;          // Only updated by restartable sequences.
+    atomic<T> shared;  // Only updated by atomic operations.
+    char padding[ATOMIC_CACHE_LINE_SIZE - 2 * sizeof(T)];
+  };
+
+  const std::size_t num_slots_;
+  std::unique_ptr<slot[]> slots_;
+
+  ATOMIC_DISALLOW_COPY(percpu_counter)
+};
+}  // namespace atomic
+
+#undef ATOMIC_PERCPU_USE_RSEQ
+
+#endif  // ATOMIC_PERCPU_COUNTER_H_
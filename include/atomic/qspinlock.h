@@ -0,0 +1,308 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_QSPINLOCK_H_
+#define ATOMIC_QSPINLOCK_H_
+
+#include "atomic/atomic.h"
+#include "atomic/spinlock.h"
+#include "atomic/wait.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace atomic {
+namespace detail {
+/// @brief A queue node of a qspinlock (one per thread and nesting level).
+struct qnode {
+  qnode() : next(0), locked(0), count(0) {}
+
+  atomic<qnode*> next;
+  atomic<int> locked;
+  int count;  // The number of nodes in use (only used in the first node).
+  char padding[ATOMIC_CACHE_LINE_SIZE];
+};
+
+/// @brief The queue nodes of all threads.
+///
+/// Each thread is given a small id (ids are recycled when threads exit), so
+/// that its nodes can be referred to by the tail field of a qspinlock.
+class qnode_registry {
+public:
+  /// @brief The number of nodes per thread (the maximum nesting depth of
+  /// queued lock operations, e.g. from signal handlers).
+  static const unsigned MAX_NESTING = 4u;
+
+  /// @brief The number of thread ids (limited by the size of the tail field).
+  static const unsigned MAX_THREADS = (1u << 14) - 1u;
+
+  /// @brief The id that is returned when all the ids are in use.
+  static const unsigned INVALID_ID = MAX_THREADS;
+
+  static qnode_registry& instance() {
+    // Note: The registry is never destroyed, since threads may exit after
+    // static objects have been destroyed.
+    static qnode_registry* s_registry = new qnode_registry();
+    return *s_registry;
+  }
+
+  /// @returns the nodes of a thread.
+  qnode* nodes_of(const unsigned id) const {
+    return blocks_[id].load(memory_order_acquire);
+  }
+
+  /// @returns a free thread id, or INVALID_ID if all ids are in use.
+  unsigned acquire_id() {
+    lock_guard guard(lock_);
+    unsigned id = INVALID_ID;
+    if (!free_ids_.empty()) {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+    } else if (num_ids_ < MAX_THREADS) {
+      id = num_ids_++;
+      // The nodes are never freed, since a recycled id reuses them.
+      blocks_[id].store(new qnode[MAX_NESTING], memory_order_release);
+    }
+    return id;
+  }
+
+  void release_id(const unsigned id) {
+    lock_guard guard(lock_);
+    free_ids_.push_back(id);
+  }
+
+private:
+  qnode_registry() : num_ids_(0u), blocks_(new atomic<qnode*>[MAX_THREADS]) {}
+
+  spinlock lock_;
+  std::vector<unsigned> free_ids_;  // Protected by lock_.
+  unsigned num_ids_;                // Protected by lock_.
+  std::unique_ptr<atomic<qnode*>[]> blocks_;
+};
+
+/// @returns the qnode_registry id of the calling thread.
+inline unsigned qnode_thread_id() {
+  struct registration {
+    registration() : id(qnode_registry::instance().acquire_id()) {}
+    ~registration() {
+      if (id != qnode_registry::INVALID_ID) {
+        qnode_registry::instance().release_id(id);
+      }
+    }
+    const unsigned id;
+  };
+  static thread_local registration s_registration;
+  return s_registration.id;
+}
+}  // namespace detail
+
+/// @brief A queued spinlock in a single 32-bit word.
+///
+/// The lock follows the design of the Linux kernel qspinlock. The lock word
+/// holds a locked byte, a pending bit and the tail of a queue of MCS nodes:
+///
+/// - An uncontended lock() is a single CAS (like a spinlock).
+/// - The first waiter sets the pending bit and spins on the lock word.
+/// - Further waiters form an MCS queue, where each waiter spins on its own
+///   (per-thread) node, so that a handoff only touches the cache lines of the
+///   lock word and of the next waiter. The tail field refers to the node of
+///   the last waiter by a thread id and a nesting index.
+///
+/// Hence the lock scales like an MCS lock, but it takes no more space than a
+/// spinlock (the nodes are shared by all the locks).
+///
+/// @note This class requires C++11.
+class qspinlock {
+public:
+  ATOMIC_CONSTEXPR qspinlock() : word_(0u) {}
+
+  /// @brief Acquire the lock (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    uint32_t val = 0u;
+    if (!word_.compare_exchange_strong(
+            val, LOCKED, memory_order_acquire, memory_order_relaxed)) {
+      lock_slow(val);
+    }
+  }
+
+  /// @brief Try to acquire the lock (non-blocking).
+  /// @returns true if the lock was acquired.
+  bool try_lock() {
+    uint32_t val = word_.load(memory_order_relaxed);
+    return val == 0u &&
+           word_.compare_exchange_strong(
+               val, LOCKED, memory_order_acquire, memory_order_relaxed);
+  }
+
+  /// @brief Release the lock.
+  /// @note It is an error to release a lock that has not been previously
+  /// acquired.
+  void unlock() {
+    word_.fetch_sub(LOCKED, memory_order_release);
+  }
+
+private:
+  // The layout of the lock word.
+  static const uint32_t LOCKED = 1u;
+  static const uint32_t LOCKED_MASK = 0xffu;
+  static const uint32_t PENDING = 1u << 8;
+  static const unsigned TAIL_IDX_OFFSET = 16u;
+  static const unsigned TAIL_ID_OFFSET = 18u;
+  static const uint32_t TAIL_MASK = 0xffff0000u;
+
+  // The number of times to wait for a pending -> locked handover.
+  static const int PENDING_LOOPS = 1;
+
+  static uint32_t encode_tail(const unsigned id, const unsigned idx) {
+    return ((id + 1u) << TAIL_ID_OFFSET) | (idx << TAIL_IDX_OFFSET);
+  }
+
+  static detail::qnode* decode_tail(const uint32_t tail) {
+    const unsigned id = (tail >> TAIL_ID_OFFSET) - 1u;
+    const unsigned idx = (tail >> TAIL_IDX_OFFSET) & 3u;
+    return detail::qnode_registry::instance().nodes_of(id) + idx;
+  }
+
+  void lock_slow(uint32_t val) {
+    // Wait for an ongoing pending -> locked handover (a few instructions).
+    for (int i = 0; i < PENDING_LOOPS && val == PENDING; ++i) {
+      detail::cpu_relax();
+      val = word_.load(memory_order_relaxed);
+    }
+
+    // If only the lock holder is present, become the pending waiter.
+    if ((val & ~LOCKED_MASK) == 0u) {
+      val = word_.fetch_or(PENDING, memory_order_acquire);
+      if ((val & ~LOCKED_MASK) == 0u) {
+        detail::spin_backoff backoff;
+        while ((word_.load(memory_order_acquire) & LOCKED_MASK) != 0u) {
+          backoff.pause();
+        }
+        // Clear the pending bit and take the lock.
+        word_.fetch_add(LOCKED - PENDING, memory_order_relaxed);
+        return;
+      }
+
+      // Another thread got there first, so undo our pending bit (unless it
+      // was set by someone else).
+      if ((val & PENDING) == 0u) {
+        word_.fetch_and(~PENDING, memory_order_relaxed);
+      }
+    }
+
+    lock_queued();
+  }
+
+  void lock_queued() {
+    const unsigned id = detail::qnode_thread_id();
+    detail::qnode* nodes = 0;
+    if (id != detail::qnode_registry::INVALID_ID) {
+      nodes = detail::qnode_registry::instance().nodes_of(id);
+    }
+    if (nodes == 0 ||
+        nodes[0].count >= static_cast<int>(
+                              detail::qnode_registry::MAX_NESTING)) {
+      // We have no queue node, so fall back to spinning.
+      detail::spin_backoff backoff;
+      while (!try_lock()) {
+        backoff.pause();
+      }
+      return;
+    }
+
+    const unsigned idx = static_cast<unsigned>(nodes[0].count++);
+    detail::qnode& node = nodes[idx];
+    node.locked.store(0, memory_order_relaxed);
+    node.next.store(0, memory_order_relaxed);
+    const uint32_t tail = encode_tail(id, idx);
+
+    if (!try_lock()) {
+      wait_in_queue(node, tail);
+    }
+
+    --nodes[0].count;
+  }
+
+  void wait_in_queue(detail::qnode& node, const uint32_t tail) {
+    // Publish our node as the new tail.
+    uint32_t old = word_.load(memory_order_relaxed);
+    while (!word_.compare_exchange_weak(old,
+                                        (old & ~TAIL_MASK) | tail,
+                                        memory_order_acq_rel,
+                                        memory_order_relaxed))
+      ;
+
+    // Link in behind the previous tail, and wait until we are at the head of
+    // the queue.
+    if ((old & TAIL_MASK) != 0u) {
+      decode_tail(old)->next.store(&node, memory_order_release);
+      detail::spin_backoff backoff;
+      while (node.locked.load(memory_order_acquire) == 0) {
+        backoff.pause();
+      }
+    }
+
+    // At the head of the queue: Wait for the owner and the pending waiter.
+    uint32_t val;
+    detail::spin_backoff backoff;
+    while (((val = word_.load(memory_order_acquire)) &
+            (LOCKED_MASK | PENDING)) != 0u) {
+      backoff.pause();
+    }
+
+    // If we are the last one in the queue, take the lock and clear the tail.
+    // The CAS may fail because a thread that is about to queue up sets (and
+    // then clears) the pending bit, so retry until the tail has moved. Such a
+    // pending bit is preserved, since its owner clears it. Only a tail that
+    // has moved guarantees that a successor will link in behind us (a thread
+    // without a queue node never does).
+    while ((val & TAIL_MASK) == tail) {
+      if (word_.compare_exchange_weak(val,
+                                      (val & PENDING) | LOCKED,
+                                      memory_order_relaxed,
+                                      memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    // Otherwise take the lock, and make the next waiter the head.
+    word_.fetch_or(LOCKED, memory_order_relaxed);
+    detail::qnode* next;
+    detail::spin_backoff link_backoff;
+    while ((next = node.next.load(memory_order_acquire)) == 0) {
+      link_backoff.pause();
+    }
+    next->locked.store(1, memory_order_release);
+  }
+
+  atomic<uint32_t> word_;
+
+  ATOMIC_DISALLOW_COPY(qspinlock)
+};
+}  // namespace atomic
+
+#endif  // ATOMIC_QSPINLOCK_H_
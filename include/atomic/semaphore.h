@@ -0,0 +1,217 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_SEMAPHORE_H_
+#define ATOMIC_SEMAPHORE_H_
+
+#include "atomic/atomic.h"
+#include "atomic/wait.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace atomic {
+/// @brief A counting semaphore.
+///
+/// Acquiring and releasing the semaphore is a single atomic operation when no
+/// thread has to wait. The count may go negative, in which case its magnitude
+/// is the number of waiting threads. Waiting threads spin for a short while
+/// before they are put to sleep (using a futex on Linux).
+///
+/// @note This class requires C++11.
+class semaphore {
+public:
+  /// @brief Construct a semaphore.
+  /// @param initial_count The initial count (must be >= 0).
+  explicit semaphore(const int32_t initial_count = 0)
+      : count_(initial_count), wakeups_(0) {}
+
+  /// @brief Decrement the count, blocking while it is zero.
+  void acquire() {
+    if (count_.fetch_sub(1) > 0) {
+      return;
+    }
+    wait_for_wakeup();
+  }
+
+  /// @brief Decrement the count if it is greater than zero (non-blocking).
+  /// @returns true if the count was decremented.
+  bool try_acquire() {
+    int32_t count = count_.load();
+    while (count > 0) {
+      if (count_.compare_exchange_weak(count, count - 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// @brief Decrement the count, blocking while it is zero, but at most for a
+  /// given duration.
+  /// @param timeout The maximum duration to wait.
+  /// @returns true if the count was decremented, or false if the timeout
+  /// expired.
+  template <typename Rep, typename Period>
+  bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout) {
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + timeout;
+    if (count_.fetch_sub(1) > 0) {
+      return true;
+    }
+    if (wait_for_wakeup_until(deadline)) {
+      return true;
+    }
+
+    // We timed out, so we must withdraw ourselves from the waiters. However,
+    // if the count is non-negative, a release has already granted us a wakeup
+    // that we must consume (it will arrive shortly).
+    int32_t count = count_.load();
+    for (;;) {
+      if (count >= 0) {
+        wait_for_wakeup();
+        return true;
+      }
+      if (count_.compare_exchange_weak(count, count + 1)) {
+        return false;
+      }
+    }
+  }
+
+  /// @brief Increment the count.
+  ///
+  /// If there are waiting threads, at most @c n of them are woken up.
+  ///
+  /// @param n The value to add to the count.
+  void release(const int32_t n = 1) {
+    const int32_t old_count = count_.fetch_add(n);
+    const int32_t num_waiters = old_count < 0 ? -old_count : 0;
+    const int32_t num_wakeups = num_waiters < n ? num_waiters : n;
+    if (num_wakeups > 0) {
+      wakeups_.fetch_add(num_wakeups);
+      detail::wake_by_address(wakeups_, num_wakeups);
+    }
+  }
+
+private:
+  static const int SPIN_COUNT = 1000;
+
+  bool try_consume_wakeup() {
+    int wakeups = wakeups_.load();
+    while (wakeups > 0) {
+      if (wakeups_.compare_exchange_weak(wakeups, wakeups - 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void wait_for_wakeup() {
+    for (int i = 0; i < SPIN_COUNT; ++i) {
+      if (try_consume_wakeup()) {
+        return;
+      }
+      detail::cpu_relax();
+    }
+    while (!try_consume_wakeup()) {
+      detail::wait_on_address(wakeups_, 0);
+    }
+  }
+
+  bool wait_for_wakeup_until(
+      const std::chrono::steady_clock::time_point& deadline) {
+    for (int i = 0; i < SPIN_COUNT; ++i) {
+      if (try_consume_wakeup()) {
+        return true;
+      }
+      detail::cpu_relax();
+    }
+    while (!try_consume_wakeup()) {
+      const std::chrono::steady_clock::duration remaining =
+          deadline - std::chrono::steady_clock::now();
+      if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        return false;
+      }
+      detail::wait_on_address_for(
+          wakeups_,
+          0,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+              .count());
+    }
+    return true;
+  }
+
+  atomic<int32_t> count_;
+  atomic<int> wakeups_;
+
+  ATOMIC_DISALLOW_COPY(semaphore)
+};
+
+/// @brief A binary semaphore.
+///
+/// This is a semaphore whose count is either zero or one.
+///
+/// @note This class requires C++11.
+class binary_semaphore {
+public:
+  /// @brief Construct a semaphore.
+  /// @param available true if the semaphore is initially available (i.e. the
+  /// count is one).
+  explicit binary_semaphore(const bool available = false)
+      : sem_(available ? 1 : 0) {}
+
+  /// @brief Take the semaphore, blocking while it is unavailable.
+  void acquire() {
+    sem_.acquire();
+  }
+
+  /// @brief Take the semaphore if it is available (non-blocking).
+  /// @returns true if the semaphore was taken.
+  bool try_acquire() {
+    return sem_.try_acquire();
+  }
+
+  /// @brief Take the semaphore, blocking while it is unavailable, but at most
+  /// for a given duration.
+  /// @param timeout The maximum duration to wait.
+  /// @returns true if the semaphore was taken.
+  template <typename Rep, typename Period>
+  bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout) {
+    return sem_.try_acquire_for(timeout);
+  }
+
+  /// @brief Make the semaphore available.
+  /// @note It is an error to release a semaphore that is already available.
+  void release() {
+    sem_.release(1);
+  }
+
+private:
+  semaphore sem_;
+
+  ATOMIC_DISALLOW_COPY(binary_semaphore)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_SEMAPHORE_H_
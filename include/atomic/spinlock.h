@@ -27,52 +27,488 @@
 
 #include "atomic/atomic.h"
 
+// Lock contention profiling can be enabled by defining ATOMIC_LOCK_STATS
+// (it must be defined the same way for all translation units of a program).
+// Each spinlock then records how it is used, and a report of all the live
+// spinlocks can be obtained via get_spinlock_stats() or
+// dump_spinlock_stats(). When ATOMIC_LOCK_STATS is not defined, none of this
+// adds any code or data to the spinlock.
+#if defined(ATOMIC_LOCK_STATS)
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define ATOMIC_CYCLE_COUNTER_USE_RDTSC
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define ATOMIC_CYCLE_COUNTER_USE_CNTVCT
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define ATOMIC_CYCLE_COUNTER_USE_MSVC_RDTSC
+#else
+#define ATOMIC_CYCLE_COUNTER_USE_CHRONO
+#include <chrono>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+extern "C" unsigned __int64 __rdtsc(void);
+#pragma intrinsic(__rdtsc)
+#endif
+#endif  // ATOMIC_LOCK_STATS
+
 namespace atomic {
+#if defined(ATOMIC_LOCK_STATS)
+/// @brief Usage statistics for a spinlock.
+struct spinlock_stats {
+  /// @brief The name of the lock (may be null).
+  const char* name;
+
+  /// @brief The address of the lock.
+  const void* address;
+
+  /// @brief The number of times that the lock has been acquired.
+  uint64_t acquisitions;
+
+  /// @brief The number of acquisitions where the lock was already held.
+  uint64_t contended_acquisitions;
+
+  /// @brief The total number of failed attempts to take the lock.
+  uint64_t spin_iterations;
+
+  /// @brief The longest time that a thread has waited for the lock, in CPU
+  /// cycles (or timer ticks, depending on the architecture).
+  uint64_t max_wait_cycles;
+};
+
+class spinlock;
+
+namespace detail {
+/// @returns the current value of a fast, monotonic cycle counter.
+inline uint64_t read_cycle_counter() {
+#if defined(ATOMIC_CYCLE_COUNTER_USE_RDTSC)
+  return __builtin_ia32_rdtsc();
+#elif defined(ATOMIC_CYCLE_COUNTER_USE_CNTVCT)
+  uint64_t count;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(count));
+  return count;
+#elif defined(ATOMIC_CYCLE_COUNTER_USE_MSVC_RDTSC)
+  return __rdtsc();
+#elif defined(ATOMIC_CYCLE_COUNTER_USE_CHRONO)
+  return static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// A registry of all live spinlocks.
+class spinlock_registry {
+public:
+  static spinlock_registry& instance() {
+    static spinlock_registry s_registry;
+    return s_registry;
+  }
+
+  void add(spinlock* lock);
+  void remove(spinlock* lock);
+  std::vector<spinlock_stats> stats();
+
+private:
+  spinlock_registry() : guard_(0), first_(0) {}
+
+  // Note: We can not use a spinlock to protect the registry, since spinlocks
+  // register themselves.
+  void lock_registry() {
+    while (guard_.exchange(1, memory_order_acquire) != 0)
+      ;
+  }
+
+  void unlock_registry() {
+    guard_.store(0, memory_order_release);
+  }
+
+  atomic<int> guard_;
+  spinlock* first_;
+};
+}  // namespace detail
+#endif  // ATOMIC_LOCK_STATS
+
 class spinlock {
 public:
-  spinlock() : value_(0) {}
+#if defined(ATOMIC_LOCK_STATS)
+  spinlock() : value_(UNLOCKED) {
+    init_stats(0);
+  }
+
+  /// @brief Construct a named lock.
+  /// @param name The name of the lock (must outlive the lock).
+  explicit spinlock(const char* name) : value_(UNLOCKED) {
+    init_stats(name);
+  }
+
+  ~spinlock() {
+    detail::spinlock_registry::instance().remove(this);
+  }
+#else
+  /// @note The constructors are constexpr (in C++11 and later), so global
+  /// locks are constant-initialized. This does not hold when ATOMIC_LOCK_STATS
+  /// is defined, since each lock then registers itself at construction.
+  ATOMIC_CONSTEXPR spinlock() : value_(UNLOCKED) {}
+
+  /// @brief Construct a named lock.
+  /// @param name The name of the lock (only used when ATOMIC_LOCK_STATS is
+  /// defined).
+  ATOMIC_CONSTEXPR explicit spinlock(const char* /* name */)
+      : value_(UNLOCKED) {}
+#endif
 
   /// @brief Acquire the lock (blocking).
   /// @note Trying to acquire a lock that is already held by the calling thread
   /// will dead-lock (block indefinitely).
   void lock() {
-    while (!value_.compare_exchange(UNLOCKED, LOCKED))
+#if defined(ATOMIC_LOCK_STATS)
+    acquisitions_.fetch_add(1, memory_order_relaxed);
+    int expected = UNLOCKED;
+    if (try_acquire(expected)) {
+      return;
+    }
+    const uint64_t start = detail::read_cycle_counter();
+    uint64_t spins = 1;
+    while (!try_acquire(expected)) {
+      ++spins;
+    }
+    record_contention(spins, detail::read_cycle_counter() - start);
+#else
+    int expected = UNLOCKED;
+    while (!try_acquire(expected))
       ;
+#endif
   }
 
   /// @brief Release the lock.
   /// @note It is an error to release a lock that has not been previously
   /// acquired.
-  void unlock() { value_.store(UNLOCKED); }
+  void unlock() { value_.store(UNLOCKED, memory_order_release); }
+
+#if defined(ATOMIC_LOCK_STATS)
+  /// @returns the usage statistics of the lock.
+  spinlock_stats stats() const {
+    spinlock_stats result;
+    result.name = name_;
+    result.address = this;
+    result.acquisitions = acquisitions_.load(memory_order_relaxed);
+    result.contended_acquisitions = contended_.load(memory_order_relaxed);
+    result.spin_iterations = spin_iterations_.load(memory_order_relaxed);
+    result.max_wait_cycles = max_wait_cycles_.load(memory_order_relaxed);
+    return result;
+  }
+#endif
 
 private:
   static const int UNLOCKED = 0;
   static const int LOCKED = 1;
 
+  // A single attempt to acquire the lock. @c expected is the last observed
+  // value of the lock word (a failed CAS updates it, so no extra load is
+  // needed). While the lock is held, we only read the lock word, to avoid
+  // stealing the cache line from the lock holder.
+  bool try_acquire(int& expected) {
+    if (expected != UNLOCKED) {
+      expected = value_.load(memory_order_relaxed);
+      return false;
+    }
+    return value_.compare_exchange_weak(
+        expected, LOCKED, memory_order_acquire, memory_order_relaxed);
+  }
+
   atomic<int> value_;
 
+#if defined(ATOMIC_LOCK_STATS)
+  friend class detail::spinlock_registry;
+
+  void init_stats(const char* name) {
+    name_ = name;
+    prev_ = 0;
+    next_ = 0;
+    detail::spinlock_registry::instance().add(this);
+  }
+
+  void record_contention(const uint64_t spins, const uint64_t wait_cycles) {
+    contended_.fetch_add(1, memory_order_relaxed);
+    spin_iterations_.fetch_add(spins, memory_order_relaxed);
+    uint64_t max_cycles = max_wait_cycles_.load(memory_order_relaxed);
+    while (wait_cycles > max_cycles &&
+           !max_wait_cycles_.compare_exchange_weak(
+               max_cycles, wait_cycles, memory_order_relaxed))
+      ;
+  }
+
+  const char* name_;
+  atomic<uint64_t> acquisitions_;
+  atomic<uint64_t> contended_;
+  atomic<uint64_t> spin_iterations_;
+  atomic<uint64_t> max_wait_cycles_;
+
+  // Links in the registry (protected by the registry lock).
+  spinlock* prev_;
+  spinlock* next_;
+#endif  // ATOMIC_LOCK_STATS
+
   ATOMIC_DISALLOW_COPY(spinlock)
 };
 
-class lock_guard {
+#if defined(ATOMIC_LOCK_STATS)
+namespace detail {
+inline void spinlock_registry::add(spinlock* lock) {
+  lock_registry();
+  lock->next_ = first_;
+  if (first_ != 0) {
+    first_->prev_ = lock;
+  }
+  first_ = lock;
+  unlock_registry();
+}
+
+inline void spinlock_registry::remove(spinlock* lock) {
+  lock_registry();
+  if (lock->prev_ != 0) {
+    lock->prev_->next_ = lock->next_;
+  } else {
+    first_ = lock->next_;
+  }
+  if (lock->next_ != 0) {
+    lock->next_->prev_ = lock->prev_;
+  }
+  unlock_registry();
+}
+
+inline std::vector<spinlock_stats> spinlock_registry::stats() {
+  std::vector<spinlock_stats> result;
+  lock_registry();
+  for (const spinlock* lock = first_; lock != 0; lock = lock->next_) {
+    result.push_back(lock->stats());
+  }
+  unlock_registry();
+  return result;
+}
+
+inline bool more_contended(const spinlock_stats& a, const spinlock_stats& b) {
+  if (a.contended_acquisitions != b.contended_acquisitions) {
+    return a.contended_acquisitions > b.contended_acquisitions;
+  }
+  return a.spin_iterations > b.spin_iterations;
+}
+}  // namespace detail
+
+/// @brief Collect the usage statistics of all live spinlocks.
+/// @returns the statistics, sorted by the number of contended acquisitions
+/// (most contended first).
+inline std::vector<spinlock_stats> get_spinlock_stats() {
+  std::vector<spinlock_stats> result =
+      detail::spinlock_registry::instance().stats();
+  std::stable_sort(result.begin(), result.end(), detail::more_contended);
+  return result;
+}
+
+/// @brief Write a contention report for all live spinlocks to a stream.
+/// @param out The output stream.
+/// @param max_locks The maximum number of locks to include in the report
+/// (the most contended locks are reported first).
+inline void dump_spinlock_stats(std::ostream& out,
+                                const std::size_t max_locks = 20) {
+  const std::vector<spinlock_stats> stats = get_spinlock_stats();
+  out << "lock                             acquisitions   contended"
+         "        spins    max wait\n";
+  for (std::size_t i = 0; i < stats.size() && i < max_locks; ++i) {
+    const spinlock_stats& s = stats[i];
+    out.width(32);
+    out.setf(std::ios::left, std::ios::adjustfield);
+    if (s.name != 0) {
+      out << s.name;
+    } else {
+      out << s.address;
+    }
+    out.setf(std::ios::right, std::ios::adjustfield);
+    out << " ";
+    out.width(12);
+    out << s.acquisitions << " ";
+    out.width(11);
+    out << s.contended_acquisitions << " ";
+    out.width(12);
+    out << s.spin_iterations << " ";
+    out.width(11);
+    out << s.max_wait_cycles << "\n";
+  }
+}
+#endif  // ATOMIC_LOCK_STATS
+
+/// @brief A spinlock that only occupies a single byte.
+///
+/// The lock is based on an atomic_flag, so locking is a single byte exchange
+/// (e.g. xchg on x86), which makes it possible to embed a lock in every object
+/// of large arrays without adding much memory.
+class byte_spinlock {
+public:
+  ATOMIC_CONSTEXPR byte_spinlock() {}
+
+  /// @brief Acquire the lock (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    while (flag_.test_and_set(memory_order_acquire)) {
+      // Wait for the lock to be released without writing to it, to avoid
+      // stealing the cache line from the lock holder.
+      while (flag_.test(memory_order_relaxed))
+        ;
+    }
+  }
+
+  /// @brief Try to acquire the lock (non-blocking).
+  /// @returns true if the lock was acquired.
+  bool try_lock() {
+    return !flag_.test(memory_order_relaxed) &&
+           !flag_.test_and_set(memory_order_acquire);
+  }
+
+  /// @brief Release the lock.
+  /// @note It is an error to release a lock that has not been previously
+  /// acquired.
+  void unlock() {
+    flag_.clear(memory_order_release);
+  }
+
+private:
+  atomic_flag flag_;
+
+  ATOMIC_DISALLOW_COPY(byte_spinlock)
+};
+
+/// @brief A spinlock that uses a single bit of an atomic word as the lock.
+///
+/// The remaining bits of the word (the payload) are free for the user, which
+/// makes it possible to add a lock to an existing word without using any extra
+/// memory, e.g. by using the low bit of an aligned pointer (stored as a
+/// uintptr_t) or a spare flag bit.
+///
+/// @tparam T An unsigned integer type.
+/// @tparam Bit The index of the bit that is used as the lock.
+template <typename T, unsigned Bit = 0>
+class bit_spinlock {
+public:
+  /// @brief Construct an unlocked word.
+  /// @param payload The initial payload (the lock bit is ignored).
+  ATOMIC_CONSTEXPR explicit bit_spinlock(const T payload = T(0))
+      : value_(static_cast<T>(payload & ~LOCK_BIT)) {}
+
+  /// @brief Acquire the lock (blocking).
+  /// @note Trying to acquire a lock that is already held by the calling thread
+  /// will dead-lock (block indefinitely).
+  void lock() {
+    while ((value_.fetch_or(LOCK_BIT, memory_order_acquire) & LOCK_BIT) != 0) {
+      // Wait for the lock to be released without writing to it.
+      while ((value_.load(memory_order_relaxed) & LOCK_BIT) != 0)
+        ;
+    }
+  }
+
+  /// @brief Try to acquire the lock (non-blocking).
+  /// @returns true if the lock was acquired.
+  bool try_lock() {
+    return (value_.load(memory_order_relaxed) & LOCK_BIT) == 0 &&
+           (value_.fetch_or(LOCK_BIT, memory_order_acquire) & LOCK_BIT) == 0;
+  }
+
+  /// @brief Release the lock.
+  /// @note It is an error to release a lock that has not been previously
+  /// acquired.
+  void unlock() {
+    value_.fetch_and(static_cast<T>(~LOCK_BIT), memory_order_release);
+  }
+
+  /// @returns true if the lock is currently held (by any thread).
+  bool is_locked() const {
+    return (value_.load(memory_order_relaxed) & LOCK_BIT) != 0;
+  }
+
+  /// @brief Read the payload (the word with the lock bit masked out).
+  /// @param order The memory ordering constraint.
+  /// @returns the payload.
+  /// @note The payload can be read without holding the lock.
+  T load(const memory_order order = memory_order_seq_cst) const {
+    return static_cast<T>(value_.load(order) & ~LOCK_BIT);
+  }
+
+  /// @brief Write the payload.
+  /// @param payload The new payload (the lock bit is ignored).
+  /// @note The calling thread must hold the lock. The new payload is published
+  /// to other threads that acquire the lock when the lock is released.
+  void store(const T payload) {
+    value_.store(static_cast<T>((payload & ~LOCK_BIT) | LOCK_BIT),
+                 memory_order_relaxed);
+  }
+
+private:
+  static const T LOCK_BIT = static_cast<T>(T(1) << Bit);
+
+  ATOMIC_STATIC_ASSERT(detail::is_integral<T>::value &&
+                           static_cast<T>(-1) > static_cast<T>(0),
+                       "bit_spinlock requires an unsigned integer type");
+  ATOMIC_STATIC_ASSERT(Bit < sizeof(T) * 8,
+                       "The lock bit must be inside the word");
+
+  atomic<T> value_;
+
+  ATOMIC_DISALLOW_COPY(bit_spinlock)
+};
+
+/// @brief A scoped lock guard for any lock type that has lock() and unlock()
+/// methods.
+template <typename Lock>
+class basic_lock_guard {
 public:
   /// @brief The constructor acquires the lock.
-  /// @param lock The spinlock that will be locked.
-  explicit lock_guard(spinlock& lock) : lock_(lock) {
+  /// @param lock The lock that will be locked.
+  explicit basic_lock_guard(Lock& lock) : lock_(lock) {
     lock_.lock();
   }
 
   /// @brief The destructor releases the lock.
-  ~lock_guard() {
+  ~basic_lock_guard() {
     lock_.unlock();
   }
 
 private:
-  spinlock& lock_;
+  Lock& lock_;
 
-  ATOMIC_DISALLOW_COPY(lock_guard)
+  ATOMIC_DISALLOW_COPY(basic_lock_guard)
+};
+
+/// @brief A scoped lock guard for a spinlock.
+typedef basic_lock_guard<spinlock> lock_guard;
+
+/// @brief A scoped lock guard that holds a reader-writer lock in shared mode,
+/// for any lock type that has lock_shared() and unlock_shared() methods.
+template <typename Lock>
+class basic_shared_lock_guard {
+public:
+  /// @brief The constructor acquires the lock in shared mode.
+  /// @param lock The lock that will be locked.
+  explicit basic_shared_lock_guard(Lock& lock) : lock_(lock) {
+    lock_.lock_shared();
+  }
+
+  /// @brief The destructor releases the lock.
+  ~basic_shared_lock_guard() {
+    lock_.unlock_shared();
+  }
+
+private:
+  Lock& lock_;
+
+  ATOMIC_DISALLOW_COPY(basic_shared_lock_guard)
 };
 
 }  // namespace atomic
 
+#undef ATOMIC_CYCLE_COUNTER_USE_RDTSC
+#undef ATOMIC_CYCLE_COUNTER_USE_CNTVCT
+#undef ATOMIC_CYCLE_COUNTER_USE_MSVC_RDTSC
+#undef ATOMIC_CYCLE_COUNTER_USE_CHRONO
+
 #endif  // ATOMIC_SPINLOCK_H_
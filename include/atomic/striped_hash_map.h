@@ -0,0 +1,313 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_STRIPED_HASH_MAP_H_
+#define ATOMIC_STRIPED_HASH_MAP_H_
+
+#include "atomic/atomic.h"
+#include "atomic/spinlock.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace atomic {
+/// @brief A thread safe hash map that uses lock striping.
+///
+/// The buckets of the map are sharded across a fixed number of spinlocks
+/// (stripes), so that threads that operate on keys in different stripes do not
+/// contend for the same lock. Growing the map acquires all the stripes (in
+/// order).
+///
+/// @note This class requires C++11.
+template <typename K,
+          typename V,
+          typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K> >
+class striped_hash_map {
+public:
+  /// @brief Construct an empty map.
+  /// @param num_stripes The number of locks (rounded up to a power of two).
+  /// @param num_buckets The initial number of buckets (rounded up to a power of
+  /// two, and at least @c num_stripes).
+  explicit striped_hash_map(std::size_t num_stripes = 16,
+                            std::size_t num_buckets = 64)
+      : num_stripes_(round_up_pow2(num_stripes)),
+        stripes_(new padded_lock[num_stripes_]),
+        buckets_(std::max(round_up_pow2(num_buckets), num_stripes_)),
+        size_(0) {}
+
+  /// @brief Insert a new key/value pair.
+  ///
+  /// If the key is already present in the map, the map is left unchanged.
+  ///
+  /// @param key The key.
+  /// @param value The value.
+  /// @returns true if the key/value pair was inserted.
+  bool insert(K key, V value) {
+    const std::size_t hash = hasher_(key);
+    bool inserted = false;
+    bool need_grow = false;
+    {
+      lock_guard guard(stripe_for(hash));
+      bucket_type& bucket = bucket_for(hash);
+      if (find_in_bucket(bucket, key) == bucket.end()) {
+        bucket.emplace_back(std::move(key), std::move(value));
+        need_grow = (++size_ > buckets_.size());
+        inserted = true;
+      }
+    }
+    if (need_grow) {
+      grow();
+    }
+    return inserted;
+  }
+
+  /// @brief Insert a new key/value pair, or replace the value of an existing
+  /// key.
+  /// @param key The key.
+  /// @param value The value.
+  /// @returns true if a new key/value pair was inserted, or false if the value
+  /// of an existing key was replaced.
+  bool insert_or_assign(K key, V value) {
+    const std::size_t hash = hasher_(key);
+    bool inserted = false;
+    bool need_grow = false;
+    {
+      lock_guard guard(stripe_for(hash));
+      bucket_type& bucket = bucket_for(hash);
+      typename bucket_type::iterator it = find_in_bucket(bucket, key);
+      if (it != bucket.end()) {
+        it->second = std::move(value);
+      } else {
+        bucket.emplace_back(std::move(key), std::move(value));
+        need_grow = (++size_ > buckets_.size());
+        inserted = true;
+      }
+    }
+    if (need_grow) {
+      grow();
+    }
+    return inserted;
+  }
+
+  /// @brief Look up the value of a key.
+  /// @param key The key.
+  /// @param[out] value A copy of the value (only written if the key was found).
+  /// @returns true if the key was found.
+  bool find(const K& key, V& value) const {
+    const std::size_t hash = hasher_(key);
+    lock_guard guard(stripe_for(hash));
+    const bucket_type& bucket = bucket_for(hash);
+    typename bucket_type::const_iterator it = find_in_bucket(bucket, key);
+    if (it == bucket.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  /// @brief Check if a key is present in the map.
+  /// @param key The key.
+  /// @returns true if the key was found.
+  bool contains(const K& key) const {
+    const std::size_t hash = hasher_(key);
+    lock_guard guard(stripe_for(hash));
+    const bucket_type& bucket = bucket_for(hash);
+    return find_in_bucket(bucket, key) != bucket.end();
+  }
+
+  /// @brief Update the value of a key in place.
+  ///
+  /// The function is called while holding the lock of the stripe that the key
+  /// belongs to, so it should be short and must not access the map.
+  ///
+  /// @param key The key.
+  /// @param fn A function that is called as fn(V&) if the key was found.
+  /// @returns true if the key was found.
+  template <typename F>
+  bool update(const K& key, F fn) {
+    const std::size_t hash = hasher_(key);
+    lock_guard guard(stripe_for(hash));
+    bucket_type& bucket = bucket_for(hash);
+    typename bucket_type::iterator it = find_in_bucket(bucket, key);
+    if (it == bucket.end()) {
+      return false;
+    }
+    fn(it->second);
+    return true;
+  }
+
+  /// @brief Remove a key from the map.
+  /// @param key The key.
+  /// @returns true if the key was found (and removed).
+  bool erase(const K& key) {
+    const std::size_t hash = hasher_(key);
+    lock_guard guard(stripe_for(hash));
+    bucket_type& bucket = bucket_for(hash);
+    typename bucket_type::iterator it = find_in_bucket(bucket, key);
+    if (it == bucket.end()) {
+      return false;
+    }
+    if (it != bucket.end() - 1) {
+      *it = std::move(bucket.back());
+    }
+    bucket.pop_back();
+    --size_;
+    return true;
+  }
+
+  /// @brief Remove all the keys from the map.
+  void clear() {
+    all_stripes_guard guard(*this);
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+      buckets_[i].clear();
+    }
+    size_.store(0);
+  }
+
+  /// @returns the number of keys in the map.
+  /// @note The returned value may be outdated if other threads modify the map.
+  std::size_t size() const {
+    return size_.load();
+  }
+
+  /// @returns the number of stripes (locks).
+  std::size_t num_stripes() const {
+    return num_stripes_;
+  }
+
+private:
+  typedef std::vector<std::pair<K, V> > bucket_type;
+
+  // Each lock is padded to a full cache line to avoid false sharing.
+  struct padded_lock {
+    spinlock lock;
+    char padding[ATOMIC_CACHE_LINE_SIZE > sizeof(spinlock)
+                     ? ATOMIC_CACHE_LINE_SIZE - sizeof(spinlock)
+                     : 1];
+  };
+
+  // Acquires all the stripes (in order) for the lifetime of the object.
+  class all_stripes_guard {
+  public:
+    explicit all_stripes_guard(const striped_hash_map& map) : map_(map) {
+      for (std::size_t i = 0; i < map_.num_stripes_; ++i) {
+        map_.stripes_[i].lock.lock();
+      }
+    }
+
+    ~all_stripes_guard() {
+      for (std::size_t i = map_.num_stripes_; i > 0; --i) {
+        map_.stripes_[i - 1].lock.unlock();
+      }
+    }
+
+  private:
+    const striped_hash_map& map_;
+
+    ATOMIC_DISALLOW_COPY(all_stripes_guard)
+  };
+
+  static std::size_t round_up_pow2(const std::size_t x) {
+    std::size_t result = 1;
+    while (result < x) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Note: The bucket count is always a multiple of the stripe count, so all
+  // the keys of a bucket map to the same stripe.
+  spinlock& stripe_for(const std::size_t hash) const {
+    return stripes_[hash & (num_stripes_ - 1)].lock;
+  }
+
+  bucket_type& bucket_for(const std::size_t hash) {
+    return buckets_[hash & (buckets_.size() - 1)];
+  }
+
+  const bucket_type& bucket_for(const std::size_t hash) const {
+    return buckets_[hash & (buckets_.size() - 1)];
+  }
+
+  typename bucket_type::iterator find_in_bucket(bucket_type& bucket,
+                                                const K& key) const {
+    typename bucket_type::iterator it = bucket.begin();
+    for (; it != bucket.end(); ++it) {
+      if (key_equal_(it->first, key)) {
+        break;
+      }
+    }
+    return it;
+  }
+
+  typename bucket_type::const_iterator find_in_bucket(
+      const bucket_type& bucket,
+      const K& key) const {
+    typename bucket_type::const_iterator it = bucket.begin();
+    for (; it != bucket.end(); ++it) {
+      if (key_equal_(it->first, key)) {
+        break;
+      }
+    }
+    return it;
+  }
+
+  void grow() {
+    all_stripes_guard guard(*this);
+
+    // Another thread may already have grown the map.
+    if (size_.load() <= buckets_.size()) {
+      return;
+    }
+
+    std::vector<bucket_type> new_buckets(buckets_.size() * 2);
+    const std::size_t mask = new_buckets.size() - 1;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+      for (typename bucket_type::iterator it = buckets_[i].begin();
+           it != buckets_[i].end();
+           ++it) {
+        new_buckets[hasher_(it->first) & mask].push_back(std::move(*it));
+      }
+    }
+    buckets_.swap(new_buckets);
+  }
+
+  const std::size_t num_stripes_;
+  std::unique_ptr<padded_lock[]> stripes_;
+  std::vector<bucket_type> buckets_;
+  atomic<std::size_t> size_;
+  Hash hasher_;
+  KeyEqual key_equal_;
+
+  ATOMIC_DISALLOW_COPY(striped_hash_map)
+};
+
+}  // namespace atomic
+
+#endif  // ATOMIC_STRIPED_HASH_MAP_H_
@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_THREAD_HINT_H_
+#define ATOMIC_THREAD_HINT_H_
+
+#include "atomic/atomic.h"
+
+#include <cstddef>
+
+namespace atomic {
+namespace detail {
+/// @brief Get the index of the calling thread.
+///
+/// Each thread gets a unique index the first time that it calls this function.
+/// The indices are assigned sequentially, starting at zero.
+///
+/// @returns the index of the calling thread.
+/// @note This function requires C++11.
+inline std::size_t thread_index() {
+  static atomic<std::size_t> s_next_index;
+  static thread_local const std::size_t index = s_next_index.fetch_add(1u);
+  return index;
+}
+
+/// @brief Get the per-thread hint.
+///
+/// The hint is used by data structures that want different threads to start
+/// working on different parts of the data (e.g. different words of a bitset),
+/// in order to reduce contention. It is initialized to a unique number for each
+/// thread, and callers are free to update it (e.g. to remember where the last
+/// successful operation took place).
+///
+/// @returns a reference to the hint of the calling thread.
+/// @note This function requires C++11.
+inline std::size_t& thread_hint() {
+  static thread_local std::size_t hint = thread_index();
+  return hint;
+}
+}  // namespace detail
+}  // namespace atomic
+
+#endif  // ATOMIC_THREAD_HINT_H_
@@ -0,0 +1,196 @@
+//-----------------------------------------------------------------------------
+// This is free and unencumbered software released into the public domain.
+//
+// Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+// this software, either in source code form or as a compiled binary, for any
+// purpose, commercial or non-commercial, and by any means.
+//
+// In jurisdictions that recognize copyright laws, the author or authors of
+// this software dedicate any and all copyright interest in the software to the
+// public domain. We make this dedication for the benefit of the public at
+// large and to the detriment of our heirs and successors. We intend this
+// dedication to be an overt act of relinquishment in perpetuity of all present
+// and future rights to this software under copyright law.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// For more information, please refer to <http://unlicense.org/>
+//-----------------------------------------------------------------------------
+
+#ifndef ATOMIC_WAIT_H_
+#define ATOMIC_WAIT_H_
+
+#include "atomic/atomic.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <climits>
+#else
+#include <thread>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+extern "C" {
+void _mm_pause(void);
+void __yield(void);
+};
+#if defined(_M_IX86) || defined(_M_X64)
+#pragma intrinsic(_mm_pause)
+#elif defined(_M_ARM) || defined(_M_ARM64)
+#pragma intrinsic(__yield)
+#endif
+#endif
+
+namespace atomic {
+namespace detail {
+/// @brief Tell the CPU that we are in a spin-wait loop.
+///
+/// This reduces the power consumption and the penalty when leaving the loop,
+/// and gives more resources to the other hardware thread of the core.
+inline void cpu_relax() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__arm__) || defined(__aarch64__))
+  __asm__ __volatile__("yield" ::: "memory");
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  _mm_pause();
+#elif defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+  __yield();
+#endif
+}
+
+/// @brief Give up the time slice of the calling thread.
+inline void yield_thread() {
+#if defined(__linux__)
+  sched_yield();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/// @brief A helper for spin-wait loops.
+///
+/// The first iterations only relax the CPU, and after that the time slice is
+/// given up in each iteration, so that a spinning thread does not starve the
+/// thread that it is waiting for when there are more threads than CPUs.
+class spin_backoff {
+public:
+  spin_backoff() : count_(0) {}
+
+  /// @brief Pause for a short while.
+  void pause() {
+    if (count_ < YIELD_THRESHOLD) {
+      ++count_;
+      cpu_relax();
+    } else {
+      yield_thread();
+    }
+  }
+
+private:
+  static const int YIELD_THRESHOLD = 1000;
+
+  int count_;
+};
+
+/// @brief Block the calling thread while the value of an atomic object equals
+/// @c expected.
+///
+/// The function may return spuriously, so the caller must re-check the
+/// condition that it is waiting for. On Linux this uses a futex, and on other
+/// systems it yields the time slice of the calling thread.
+///
+/// @param a The atomic object.
+/// @param expected The value to wait on.
+inline void wait_on_address(atomic<int>& a, const int expected) {
+#if defined(__linux__)
+  ATOMIC_STATIC_ASSERT(sizeof(atomic<int>) == sizeof(int),
+                       "atomic<int> must be layout compatible with int");
+  syscall(SYS_futex,
+          reinterpret_cast<int*>(&a),
+          FUTEX_WAIT_PRIVATE,
+          expected,
+          static_cast<void*>(0),
+          static_cast<void*>(0),
+          0);
+#else
+  if (a.load() == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+/// @brief Block the calling thread while the value of an atomic object equals
+/// @c expected, or until a timeout has expired.
+///
+/// Just like wait_on_address(), the function may return spuriously (and it
+/// does not tell if the timeout expired), so the caller must keep track of the
+/// time itself.
+///
+/// @param a The atomic object.
+/// @param expected The value to wait on.
+/// @param timeout_ns The maximum time to wait, in nanoseconds.
+inline void wait_on_address_for(atomic<int>& a,
+                                const int expected,
+                                const long long timeout_ns) {
+#if defined(__linux__)
+  struct timespec timeout;
+  timeout.tv_sec = static_cast<time_t>(timeout_ns / 1000000000LL);
+  timeout.tv_nsec = static_cast<long>(timeout_ns % 1000000000LL);
+  syscall(SYS_futex,
+          reinterpret_cast<int*>(&a),
+          FUTEX_WAIT_PRIVATE,
+          expected,
+          &timeout,
+          static_cast<void*>(0),
+          0);
+#else
+  (void)timeout_ns;
+  if (a.load() == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+/// @brief Wake threads that are blocked in wait_on_address() on an atomic
+/// object.
+/// @param a The atomic object.
+/// @param count The maximum number of threads to wake.
+inline void wake_by_address(atomic<int>& a, const int count) {
+#if defined(__linux__)
+  syscall(SYS_futex,
+          reinterpret_cast<int*>(&a),
+          FUTEX_WAKE_PRIVATE,
+          count,
+          static_cast<void*>(0),
+          static_cast<void*>(0),
+          0);
+#else
+  (void)a;
+  (void)count;
+#endif
+}
+
+/// @brief Wake all threads that are blocked in wait_on_address() on an atomic
+/// object.
+/// @param a The atomic object.
+inline void wake_all_by_address(atomic<int>& a) {
+#if defined(__linux__)
+  wake_by_address(a, INT_MAX);
+#else
+  (void)a;
+#endif
+}
+}  // namespace detail
+}  // namespace atomic
+
+#endif  // ATOMIC_WAIT_H_
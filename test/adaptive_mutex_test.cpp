@@ -0,0 +1,120 @@
+#include "atomic/adaptive_mutex.h"
+#include "atomic/spinlock.h"
+
+#include "doctest.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+// Note: Copies, since doctest takes the operands by reference.
+const int MIN_SPINS = atomic::adaptive_mutex::MIN_SPINS;
+const int MAX_SPINS = atomic::adaptive_mutex::MAX_SPINS;
+}  // namespace
+
+TEST_CASE("adaptive_mutex single threaded operation") {
+  SUBCASE("try_lock fails while the lock is held") {
+    atomic::adaptive_mutex lock;
+    CHECK(lock.try_lock());
+    CHECK(!lock.try_lock());
+    lock.unlock();
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+
+  SUBCASE("The initial spin budget is the minimum") {
+    atomic::adaptive_mutex lock;
+    CHECK(lock.spin_budget() == MIN_SPINS);
+  }
+}
+
+TEST_CASE("adaptive_mutex multi threaded operation") {
+  SUBCASE("Increments from 16 threads are mutually excluded") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 10000;
+    atomic::adaptive_mutex lock;
+
+    // Protected by the lock.
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&lock, &counter] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<atomic::adaptive_mutex> guard(lock);
+          ++counter;
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(counter == NUM_THREADS * NUM_ITERATIONS);
+    CHECK(lock.spin_budget() >= MIN_SPINS);
+    CHECK(lock.spin_budget() <= MAX_SPINS);
+  }
+
+  SUBCASE("A waiter parks and is woken up") {
+    atomic::adaptive_mutex lock;
+    atomic::atomic<int> acquired(0);
+
+    lock.lock();
+    std::thread waiter([&lock, &acquired] {
+      lock.lock();
+      acquired.store(1);
+      lock.unlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(acquired.load() == 0);
+    lock.unlock();
+    waiter.join();
+
+    CHECK(acquired.load() == 1);
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+
+  SUBCASE("The spin budget shrinks after a run of long holds") {
+    const int NUM_THREADS = 4;
+    const int NUM_ITERATIONS = 20000;
+    const int NUM_LONG_HOLDS = 64;
+    atomic::adaptive_mutex lock;
+
+    // Short critical sections, which may make the budget grow.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&lock] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          lock.lock();
+          lock.unlock();
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const int short_budget = lock.spin_budget();
+
+    // Long critical sections, where every waiter spins in vain and parks.
+    for (int k = 0; k < NUM_LONG_HOLDS; ++k) {
+      atomic::atomic<int> waiting(0);
+      lock.lock();
+      std::thread waiter([&lock, &waiting] {
+        waiting.store(1);
+        lock.lock();
+        lock.unlock();
+      });
+      while (waiting.load() == 0) {
+        std::this_thread::yield();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      lock.unlock();
+      waiter.join();
+    }
+
+    CHECK(lock.spin_budget() <= short_budget);
+    CHECK(lock.spin_budget() == MIN_SPINS);
+  }
+}
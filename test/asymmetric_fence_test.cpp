@@ -0,0 +1,79 @@
+#include "atomic/asymmetric_fence.h"
+
+#include "doctest.h"
+
+#include <thread>
+
+namespace {
+// A Dekker style handshake: each side announces itself with a relaxed store
+// and then checks the other side. With a light fence on one side and a heavy
+// fence on the other side, at most one side may see the other side as absent.
+template <typename HeavyFence>
+int count_mutual_exclusion_errors(HeavyFence heavy_fence,
+                                  const int num_rounds) {
+  atomic::atomic<int> light_flag(0);
+  atomic::atomic<int> heavy_flag(0);
+  atomic::atomic<int> round(0);
+  atomic::atomic<int> done(0);
+  atomic::atomic<int> num_inside(0);
+  int errors = 0;
+
+  std::thread light_thread([&] {
+    for (int r = 1; r <= num_rounds; ++r) {
+      while (round.load(atomic::memory_order_acquire) < r) {
+        std::this_thread::yield();
+      }
+      light_flag.store(1, atomic::memory_order_relaxed);
+      atomic::asymmetric_thread_fence_light();
+      if (heavy_flag.load(atomic::memory_order_relaxed) == 0) {
+        num_inside.fetch_add(1);
+      }
+      done.fetch_add(1, atomic::memory_order_release);
+    }
+  });
+
+  for (int r = 1; r <= num_rounds; ++r) {
+    light_flag.store(0, atomic::memory_order_relaxed);
+    heavy_flag.store(0, atomic::memory_order_relaxed);
+    num_inside.store(0);
+    round.store(r, atomic::memory_order_release);
+
+    heavy_flag.store(1, atomic::memory_order_relaxed);
+    heavy_fence();
+    if (light_flag.load(atomic::memory_order_relaxed) == 0) {
+      num_inside.fetch_add(1);
+    }
+
+    while (done.load(atomic::memory_order_acquire) < r) {
+      std::this_thread::yield();
+    }
+    if (num_inside.load() > 1) {
+      ++errors;
+    }
+  }
+  light_thread.join();
+  return errors;
+}
+}  // namespace
+
+TEST_CASE("Asymmetric fences") {
+  SUBCASE("The fences can be called") {
+    atomic::asymmetric_thread_fence_light();
+    atomic::asymmetric_thread_fence_heavy();
+    atomic::asymmetric_thread_fence_heavy();
+  }
+
+  SUBCASE("A light and a heavy fence order a Dekker style handshake") {
+    const int errors = count_mutual_exclusion_errors(
+        [] { atomic::asymmetric_thread_fence_heavy(); }, 2000);
+    CHECK(errors == 0);
+  }
+
+#if defined(__linux__)
+  SUBCASE("The mprotect based heavy fence orders a Dekker style handshake") {
+    const int errors = count_mutual_exclusion_errors(
+        [] { atomic::detail::mprotect_fence(); }, 2000);
+    CHECK(errors == 0);
+  }
+#endif
+}
@@ -0,0 +1,93 @@
+#include "atomic/atomic_bitset.h"
+
+#include "doctest.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+TEST_CASE("atomic_bitset single threaded operation") {
+  SUBCASE("A new bitset has all bits cleared") {
+    atomic::atomic_bitset<100> bits;
+    CHECK(bits.size() == 100u);
+    CHECK(bits.count() == 0u);
+    CHECK(bits.test(0) == false);
+    CHECK(bits.test(99) == false);
+  }
+
+  SUBCASE("test_and_set returns the old value") {
+    atomic::atomic_bitset<100> bits;
+    CHECK(bits.test_and_set(70) == false);
+    CHECK(bits.test_and_set(70) == true);
+    CHECK(bits.test(70) == true);
+    CHECK(bits.count() == 1u);
+  }
+
+  SUBCASE("reset returns the old value") {
+    atomic::atomic_bitset<100> bits;
+    bits.test_and_set(3);
+    CHECK(bits.reset(3) == true);
+    CHECK(bits.reset(3) == false);
+    CHECK(bits.test(3) == false);
+  }
+
+  SUBCASE("acquire_free hands out every bit exactly once") {
+    atomic::atomic_bitset<130> bits;
+    std::vector<int> seen(130, 0);
+    for (int i = 0; i < 130; ++i) {
+      const std::size_t pos = bits.acquire_free();
+      REQUIRE(pos < 130u);
+      ++seen[pos];
+    }
+    CHECK(bits.acquire_free() == atomic::atomic_bitset<130>::npos);
+    CHECK(bits.count() == 130u);
+    bool all_once = true;
+    for (int i = 0; i < 130; ++i) {
+      all_once = all_once && (seen[i] == 1);
+    }
+    CHECK(all_once);
+  }
+
+  SUBCASE("acquire_free reuses released bits") {
+    atomic::atomic_bitset<64> bits;
+    for (int i = 0; i < 64; ++i) {
+      bits.acquire_free();
+    }
+    bits.reset(17);
+    CHECK(bits.acquire_free() == 17u);
+    CHECK(bits.acquire_free() == atomic::atomic_bitset<64>::npos);
+  }
+}
+
+TEST_CASE("atomic_bitset multi threaded operation") {
+  SUBCASE("acquire_free with 16 threads never hands out a bit twice") {
+    const int NUM_THREADS = 16;
+    const int NUM_PER_THREAD = 200;
+    atomic::atomic_bitset<NUM_THREADS * NUM_PER_THREAD> bits;
+
+    std::vector<std::vector<std::size_t> > acquired(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&bits, &acquired, i, &NUM_PER_THREAD]() {
+        for (int k = 0; k < NUM_PER_THREAD; ++k) {
+          acquired[i].push_back(bits.acquire_free());
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    std::vector<int> seen(NUM_THREADS * NUM_PER_THREAD, 0);
+    bool all_valid = true;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      for (std::size_t k = 0; k < acquired[i].size(); ++k) {
+        const std::size_t pos = acquired[i][k];
+        all_valid = all_valid && (pos < seen.size()) && (++seen[pos] == 1);
+      }
+    }
+    CHECK(all_valid);
+    CHECK(bits.count() ==
+          static_cast<std::size_t>(NUM_THREADS * NUM_PER_THREAD));
+  }
+}
@@ -0,0 +1,86 @@
+#include "atomic/atomic_ref.h"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("atomic_ref single threaded operation") {
+  SUBCASE("Operations are applied to the referenced object") {
+    int32_t x = 5;
+    atomic::atomic_ref<int32_t> ref(x);
+    CHECK(ref.load() == 5);
+    CHECK(ref.fetch_add(3) == 5);
+    CHECK(++ref == 9);
+    CHECK(ref.exchange(2) == 9);
+    ref = 7;
+    CHECK(x == 7);
+  }
+
+  SUBCASE("compare_exchange_strong returns the observed value on failure") {
+    int64_t x = 42;
+    atomic::atomic_ref<int64_t> ref(x);
+    int64_t expected = 0;
+    CHECK(ref.compare_exchange_strong(expected, 1) == false);
+    CHECK(expected == 42);
+    CHECK(ref.compare_exchange_strong(expected, 1) == true);
+    CHECK(x == 1);
+  }
+
+  SUBCASE("Copies refer to the same object") {
+    uint16_t x = 1;
+    atomic::atomic_ref<uint16_t> ref1(x);
+    atomic::atomic_ref<uint16_t> ref2(ref1);
+    ref2.fetch_or(6);
+    CHECK(ref1.load() == 7);
+  }
+
+  SUBCASE("Floating point values are supported") {
+    double x = 1.0;
+    atomic::atomic_ref<double> ref(x);
+    ref.fetch_add(0.5);
+    ref.fetch_max(-3.0);
+    CHECK(x == 1.5);
+  }
+
+  SUBCASE("is_aligned checks the required alignment") {
+    int64_t buffer[2] = {0, 0};
+    CHECK(atomic::atomic_ref<int64_t>::required_alignment == 8u);
+    CHECK(atomic::atomic_ref<int64_t>::is_aligned(&buffer[1]) == true);
+    const int64_t* misaligned = reinterpret_cast<const int64_t*>(
+        reinterpret_cast<const char*>(&buffer[0]) + 4);
+    CHECK(atomic::atomic_ref<int64_t>::is_aligned(misaligned) == false);
+  }
+}
+
+TEST_CASE("atomic_ref multi threaded operation") {
+  SUBCASE("Histogram bins in a plain array with 16 threads") {
+    const int NUM_BINS = 64;
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = NUM_BINS * 200;
+    std::vector<uint32_t> bins(NUM_BINS, 0u);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&bins, i, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::atomic_ref<uint32_t> bin(bins[(k + i) % NUM_BINS]);
+          bin.fetch_add(1u, atomic::memory_order_relaxed);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    uint32_t total = 0u;
+    bool all_equal = true;
+    for (int b = 0; b < NUM_BINS; ++b) {
+      total += bins[b];
+      all_equal = all_equal && (bins[b] == bins[0]);
+    }
+    CHECK(total == static_cast<uint32_t>(NUM_THREADS * NUM_ITERATIONS));
+    CHECK(all_equal);
+  }
+}
@@ -3,6 +3,7 @@
 
 #include "doctest.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <thread>
 #include <vector>
@@ -56,6 +57,83 @@ TEST_CASE_TEMPLATE("Basic atomic<int> single threaded operation",
     CHECK(a.load() == static_cast<T>(9));
   }
 
+  SUBCASE("compare_exchange_strong returns the observed value on failure") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    T expected = static_cast<T>(4);
+    CHECK(a.compare_exchange_strong(expected, static_cast<T>(9)) == false);
+    CHECK(expected == static_cast<T>(5));
+    CHECK(a.compare_exchange_strong(expected,
+                                    static_cast<T>(9),
+                                    atomic::memory_order_acq_rel,
+                                    atomic::memory_order_acquire) == true);
+    CHECK(a.load() == static_cast<T>(9));
+  }
+
+  SUBCASE("compare_exchange_weak succeeds in a loop") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    T expected = static_cast<T>(0);
+    while (!a.compare_exchange_weak(
+        expected, static_cast<T>(expected + 1), atomic::memory_order_release))
+      ;
+    CHECK(expected == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(6));
+  }
+
+  SUBCASE("Operations accept explicit memory orders") {
+    atomic::atomic<T> a;
+    a.store(static_cast<T>(5), atomic::memory_order_release);
+    CHECK(a.load(atomic::memory_order_acquire) == static_cast<T>(5));
+    CHECK(a.fetch_add(static_cast<T>(1), atomic::memory_order_relaxed) ==
+          static_cast<T>(5));
+    CHECK(a.exchange(static_cast<T>(2), atomic::memory_order_acq_rel) ==
+          static_cast<T>(6));
+    CHECK(a.load(atomic::memory_order_relaxed) == static_cast<T>(2));
+  }
+
+  SUBCASE("fetch_add updates and returns the old value") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    const T old_value = a.fetch_add(static_cast<T>(3));
+    CHECK(old_value == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(8));
+  }
+
+  SUBCASE("fetch_sub updates and returns the old value") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    const T old_value = a.fetch_sub(static_cast<T>(7));
+    CHECK(old_value == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(-2));
+  }
+
+  SUBCASE("fetch_or updates and returns the old value") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    const T old_value = a.fetch_or(static_cast<T>(10));
+    CHECK(old_value == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(15));
+  }
+
+  SUBCASE("fetch_and updates and returns the old value") {
+    atomic::atomic<T> a(static_cast<T>(13));
+    const T old_value = a.fetch_and(static_cast<T>(6));
+    CHECK(old_value == static_cast<T>(13));
+    CHECK(a.load() == static_cast<T>(4));
+  }
+
+  SUBCASE("fetch_max only replaces smaller values") {
+    atomic::atomic<T> a(static_cast<T>(-5));
+    CHECK(a.fetch_max(static_cast<T>(-7)) == static_cast<T>(-5));
+    CHECK(a.load() == static_cast<T>(-5));
+    CHECK(a.fetch_max(static_cast<T>(3)) == static_cast<T>(-5));
+    CHECK(a.load() == static_cast<T>(3));
+  }
+
+  SUBCASE("fetch_min only replaces larger values") {
+    atomic::atomic<T> a(static_cast<T>(5));
+    CHECK(a.fetch_min(static_cast<T>(7)) == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(5));
+    CHECK(a.fetch_min(static_cast<T>(-3)) == static_cast<T>(5));
+    CHECK(a.load() == static_cast<T>(-3));
+  }
+
   SUBCASE("exchange updates and returns the old value") {
     atomic::atomic<T> a(static_cast<T>(5));
     const T old_value = a.exchange(static_cast<T>(9));
@@ -64,6 +142,278 @@ TEST_CASE_TEMPLATE("Basic atomic<int> single threaded operation",
   }
 }
 
+typedef doctest::Types<float, double> atomic_float_test_types;
+
+TEST_CASE_TEMPLATE("atomic<> floating point single threaded operation",
+                   T,
+                   atomic_float_test_types) {
+  SUBCASE("atomic<> initializes to zero") {
+    atomic::atomic<T> a;
+    CHECK(a.load() == static_cast<T>(0));
+  }
+
+  SUBCASE("Incrementing atomic<> works as expected") {
+    atomic::atomic<T> a(static_cast<T>(1.5));
+    CHECK(++a == static_cast<T>(2.5));
+    CHECK(--a == static_cast<T>(1.5));
+  }
+
+  SUBCASE("fetch_add and fetch_sub return the old value") {
+    atomic::atomic<T> a(static_cast<T>(0.25));
+    CHECK(a.fetch_add(static_cast<T>(1.0)) == static_cast<T>(0.25));
+    CHECK(a.fetch_sub(static_cast<T>(0.5)) == static_cast<T>(1.25));
+    CHECK(a.load() == static_cast<T>(0.75));
+  }
+
+  SUBCASE("fetch_max and fetch_min keep the extreme values") {
+    atomic::atomic<T> hi(static_cast<T>(1.0));
+    atomic::atomic<T> lo(static_cast<T>(1.0));
+    hi.fetch_max(static_cast<T>(3.5));
+    hi.fetch_max(static_cast<T>(-2.0));
+    lo.fetch_min(static_cast<T>(3.5));
+    lo.fetch_min(static_cast<T>(-2.0));
+    CHECK(hi.load() == static_cast<T>(3.5));
+    CHECK(lo.load() == static_cast<T>(-2.0));
+  }
+
+  SUBCASE("compare_exchange compares bits") {
+    atomic::atomic<T> a(static_cast<T>(-0.0));
+    CHECK(a.compare_exchange(static_cast<T>(0.0), static_cast<T>(1.0)) ==
+          false);
+    CHECK(a.compare_exchange(static_cast<T>(-0.0), static_cast<T>(1.0)) ==
+          true);
+    CHECK(a.exchange(static_cast<T>(2.0)) == static_cast<T>(1.0));
+  }
+}
+
+namespace {
+struct point {
+  int32_t x;
+  int32_t y;
+};
+
+bool operator==(const point& a, const point& b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+#if defined(ATOMIC_HAS_DWCAS)
+struct tagged_pointer {
+  void* ptr;
+  uint64_t tag;
+};
+#endif
+}  // namespace
+
+TEST_CASE("atomic<> of trivially copyable structs") {
+  SUBCASE("atomic<point> initializes to zero") {
+    atomic::atomic<point> a;
+    const point zero = {0, 0};
+    CHECK(a.load() == zero);
+  }
+
+  SUBCASE("atomic<point> supports load, store, exchange and CAS") {
+    const point p1 = {1, 2};
+    const point p2 = {3, 4};
+    const point p3 = {5, 6};
+    atomic::atomic<point> a(p1);
+    CHECK(a.load() == p1);
+    a.store(p2);
+    CHECK(a.exchange(p3) == p2);
+    CHECK(a.compare_exchange(p1, p2) == false);
+    CHECK(a.compare_exchange(p3, p1) == true);
+    CHECK(a.load() == p1);
+  }
+
+#if defined(ATOMIC_HAS_DWCAS)
+  SUBCASE("atomic<tagged_pointer> uses a double-width CAS") {
+    int x = 0;
+    const tagged_pointer t1 = {&x, 1};
+    const tagged_pointer t2 = {&x, 2};
+    atomic::atomic<tagged_pointer> a(t1);
+    CHECK(a.load().tag == 1u);
+    CHECK(a.compare_exchange(t2, t1) == false);
+    CHECK(a.compare_exchange(t1, t2) == true);
+    CHECK(a.load().tag == 2u);
+    CHECK(a.load().ptr == &x);
+  }
+#endif
+}
+
+TEST_CASE("fetch_max and fetch_min respect signedness") {
+  SUBCASE("Unsigned values with the top bit set are large") {
+    atomic::atomic<uint32_t> a(1u);
+    CHECK(a.fetch_max(0x80000000u) == 1u);
+    CHECK(a.load() == 0x80000000u);
+    CHECK(a.fetch_min(2u, atomic::memory_order_relaxed) == 0x80000000u);
+    CHECK(a.load() == 2u);
+  }
+
+  SUBCASE("Negative values are small") {
+    atomic::atomic<int8_t> a(static_cast<int8_t>(1));
+    CHECK(a.fetch_min(static_cast<int8_t>(-128)) == 1);
+    CHECK(a.load() == -128);
+    CHECK(a.fetch_max(static_cast<int8_t>(127), atomic::memory_order_acq_rel) ==
+          -128);
+    CHECK(a.load() == 127);
+  }
+}
+
+TEST_CASE("atomic_flag single threaded operation") {
+  SUBCASE("atomic_flag occupies a single byte") {
+    CHECK(sizeof(atomic::atomic_flag) == 1u);
+  }
+
+  SUBCASE("atomic_flag initializes to clear") {
+    atomic::atomic_flag flag;
+    CHECK(flag.test() == false);
+  }
+
+  SUBCASE("test_and_set returns the previous state") {
+    atomic::atomic_flag flag;
+    CHECK(flag.test_and_set() == false);
+    CHECK(flag.test_and_set(atomic::memory_order_acquire) == true);
+    CHECK(flag.test(atomic::memory_order_relaxed) == true);
+  }
+
+  SUBCASE("clear resets the flag") {
+    atomic::atomic_flag flag;
+    flag.test_and_set();
+    flag.clear(atomic::memory_order_release);
+    CHECK(flag.test() == false);
+  }
+}
+
+TEST_CASE("bit_spinlock single threaded operation") {
+  SUBCASE("bit_spinlock does not add any memory") {
+    CHECK(sizeof(atomic::bit_spinlock<uint32_t, 31>) == sizeof(uint32_t));
+    CHECK(sizeof(atomic::bit_spinlock<uintptr_t>) == sizeof(uintptr_t));
+  }
+
+  SUBCASE("The payload is preserved when locking and unlocking") {
+    atomic::bit_spinlock<uint32_t, 31> word(0x1234u);
+    CHECK(word.is_locked() == false);
+    word.lock();
+    CHECK(word.is_locked() == true);
+    CHECK(word.load() == 0x1234u);
+    CHECK(word.try_lock() == false);
+    word.unlock();
+    CHECK(word.is_locked() == false);
+    CHECK(word.load() == 0x1234u);
+  }
+
+  SUBCASE("store replaces the payload but keeps the lock bit") {
+    atomic::bit_spinlock<uintptr_t> word;
+    int x = 0;
+    word.lock();
+    word.store(reinterpret_cast<uintptr_t>(&x) | 1u);
+    CHECK(word.is_locked() == true);
+    word.unlock();
+    CHECK(reinterpret_cast<int*>(word.load()) == &x);
+  }
+}
+
+TEST_CASE("Fences") {
+  SUBCASE("Fences can be issued with all memory orders") {
+    const atomic::memory_order orders[] = {atomic::memory_order_relaxed,
+                                           atomic::memory_order_consume,
+                                           atomic::memory_order_acquire,
+                                           atomic::memory_order_release,
+                                           atomic::memory_order_acq_rel,
+                                           atomic::memory_order_seq_cst};
+    for (int i = 0; i < 6; ++i) {
+      atomic::thread_fence(orders[i]);
+      atomic::signal_fence(orders[i]);
+    }
+  }
+
+  SUBCASE("Release and acquire fences order relaxed accesses") {
+    const int NUM_ITERATIONS = 1000;
+    atomic::atomic<int> data[4];
+    atomic::atomic<int> flag;
+    atomic::atomic<int> errors;
+
+    std::thread consumer([&data, &flag, &errors, &NUM_ITERATIONS]() {
+      for (int k = 1; k <= NUM_ITERATIONS; ++k) {
+        while (flag.load(atomic::memory_order_relaxed) != k) {
+          std::this_thread::yield();
+        }
+        atomic::thread_fence(atomic::memory_order_acquire);
+        for (int i = 0; i < 4; ++i) {
+          if (data[i].load(atomic::memory_order_relaxed) != k) {
+            ++errors;
+          }
+        }
+        flag.store(-k, atomic::memory_order_relaxed);
+      }
+    });
+    for (int k = 1; k <= NUM_ITERATIONS; ++k) {
+      for (int i = 0; i < 4; ++i) {
+        data[i].store(k, atomic::memory_order_relaxed);
+      }
+      atomic::thread_fence(atomic::memory_order_release);
+      flag.store(k, atomic::memory_order_relaxed);
+      while (flag.load(atomic::memory_order_relaxed) != -k) {
+        std::this_thread::yield();
+      }
+    }
+    consumer.join();
+
+    CHECK(errors.load() == 0);
+  }
+}
+
+// Constant initialization of global objects. The objects are used by the
+// dynamic initializers below, which run before the objects are defined (in the
+// order of definition). Had the objects been dynamically initialized, their
+// constructors would have run afterwards and undone the changes.
+#if __cplusplus >= 202002L
+#define TEST_CONSTINIT constinit
+#else
+#define TEST_CONSTINIT
+#endif
+
+namespace {
+int s_target;
+
+extern atomic::atomic<int> s_const_int;
+extern atomic::atomic<int*> s_const_ptr;
+extern atomic::byte_spinlock s_const_byte_lock;
+extern atomic::bit_spinlock<uint32_t> s_const_bit_lock;
+
+const int s_early_int = s_const_int.fetch_add(1);
+int* const s_early_ptr = s_const_ptr.exchange(&s_target);
+const bool s_early_byte_lock = s_const_byte_lock.try_lock();
+const bool s_early_bit_lock = s_const_bit_lock.try_lock();
+
+TEST_CONSTINIT atomic::atomic<int> s_const_int(42);
+TEST_CONSTINIT atomic::atomic<int*> s_const_ptr;
+TEST_CONSTINIT atomic::spinlock s_const_lock;
+TEST_CONSTINIT atomic::byte_spinlock s_const_byte_lock;
+TEST_CONSTINIT atomic::bit_spinlock<uint32_t> s_const_bit_lock(6);
+}  // namespace
+
+TEST_CASE("Global objects are constant-initialized") {
+  CHECK(s_early_int == 42);
+  CHECK(s_const_int.load() == 43);
+
+  CHECK(s_early_ptr == nullptr);
+  CHECK(s_const_ptr.load() == &s_target);
+
+  // Note: The spinlock can not be probed without a try_lock(), but it is
+  // checked by the compiler when constinit is available.
+  s_const_lock.lock();
+  s_const_lock.unlock();
+
+  CHECK(s_early_byte_lock);
+  CHECK(!s_const_byte_lock.try_lock());
+  s_const_byte_lock.unlock();
+
+  CHECK(s_early_bit_lock);
+  CHECK(s_const_bit_lock.is_locked());
+  CHECK(s_const_bit_lock.load() == 6u);
+  s_const_bit_lock.unlock();
+}
+
 TEST_CASE("atomic<int> multi threaded operation") {
   SUBCASE("atomic<int> increments correctly with 100 threads") {
     atomic_int a;
@@ -105,6 +455,151 @@ TEST_CASE("atomic<int> multi threaded operation") {
     CHECK(a.load() == -(NUM_THREADS * NUM_ITERATIONS));
   }
 
+  SUBCASE("atomic<int64_t> is naturally aligned") {
+    struct wrapper {
+      char c;
+      atomic::atomic<int64_t> a;
+    };
+    CHECK(alignof(wrapper) == 8u);
+    CHECK(offsetof(wrapper, a) == 8u);
+  }
+
+  SUBCASE("atomic<int64_t> loads and stores are never torn") {
+    const int64_t A = static_cast<int64_t>(0x0123456789abcdefLL);
+    const int64_t B = ~A;
+    atomic::atomic<int64_t> a(A);
+    atomic::atomic<int> done;
+    atomic::atomic<int> torn;
+
+    const int NUM_READERS = 4;
+    std::vector<std::thread> threads;
+    threads.push_back(std::thread([&a, &done, &A, &B]() {
+      for (int k = 0; k < 100000; ++k) {
+        a.store((k & 1) ? A : B);
+      }
+      done.store(1);
+    }));
+    for (int i = 0; i < NUM_READERS; i++) {
+      threads.push_back(std::thread([&a, &done, &torn, &A, &B]() {
+        while (done.load() == 0) {
+          const int64_t value = a.load();
+          if (value != A && value != B) {
+            ++torn;
+          }
+        }
+      }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+    }
+
+    CHECK(torn.load() == 0);
+  }
+
+  SUBCASE("atomic<int64_t> carries across 32 bits with 100 threads") {
+    atomic::atomic<int64_t> a(0xfffff000LL);
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&a, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          a.fetch_add(1);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(a.load() == 0xfffff000LL + NUM_THREADS * NUM_ITERATIONS);
+  }
+
+  SUBCASE("compare_exchange_weak loops with 100 threads") {
+    atomic::atomic<int> a;
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&a, &NUM_ITERATIONS]() {
+        int expected = a.load(atomic::memory_order_relaxed);
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          // Note: On failure, expected is updated with the observed value.
+          while (!a.compare_exchange_weak(expected,
+                                          expected + 3,
+                                          atomic::memory_order_relaxed,
+                                          atomic::memory_order_relaxed))
+            ;
+          expected += 3;
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(a.load() == NUM_THREADS * NUM_ITERATIONS * 3);
+  }
+
+  SUBCASE("atomic<int> high-water mark with 100 threads") {
+    atomic::atomic<int> high;
+    atomic::atomic<int> low;
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&high, &low, i, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          const int value = (k * 7919 + i * 104729) % 100000 - 50000;
+          high.fetch_max(value, atomic::memory_order_relaxed);
+          low.fetch_min(value, atomic::memory_order_relaxed);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    int expected_high = 0;
+    int expected_low = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      for (int k = 0; k < NUM_ITERATIONS; ++k) {
+        const int value = (k * 7919 + i * 104729) % 100000 - 50000;
+        expected_high = value > expected_high ? value : expected_high;
+        expected_low = value < expected_low ? value : expected_low;
+      }
+    }
+    CHECK(high.load() == expected_high);
+    CHECK(low.load() == expected_low);
+  }
+
+  SUBCASE("atomic<double> sums and maxima with 100 threads") {
+    atomic::atomic<double> sum;
+    atomic::atomic<double> max;
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&sum, &max, i, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          sum.fetch_add(0.5, atomic::memory_order_relaxed);
+          max.fetch_max(static_cast<double>(i * NUM_ITERATIONS + k),
+                        atomic::memory_order_relaxed);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(sum.load() == 0.5 * NUM_THREADS * NUM_ITERATIONS);
+    CHECK(max.load() == static_cast<double>(NUM_THREADS * NUM_ITERATIONS - 1));
+  }
+
   SUBCASE("spinlock with 100 threads") {
     atomic::spinlock lock;
     int unsafe_value = 0;
@@ -156,4 +651,67 @@ TEST_CASE("atomic<int> multi threaded operation") {
 
     CHECK(unsafe_value == (NUM_THREADS * NUM_ITERATIONS));
   }
+
+  SUBCASE("byte_spinlock with 100 threads") {
+    atomic::byte_spinlock lock;
+    int unsafe_value = 0;
+
+    CHECK(sizeof(lock) == 1u);
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&lock, &unsafe_value, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<atomic::byte_spinlock> guard(lock);
+
+          // Update the unsafe value (now protected by our acquired lock).
+          ++unsafe_value;
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(unsafe_value == (NUM_THREADS * NUM_ITERATIONS));
+  }
+
+  SUBCASE("byte_spinlock try_lock fails while the lock is held") {
+    atomic::byte_spinlock lock;
+    CHECK(lock.try_lock() == true);
+    CHECK(lock.try_lock() == false);
+    lock.unlock();
+    CHECK(lock.try_lock() == true);
+    lock.unlock();
+  }
+
+  SUBCASE("bit_spinlock with 100 threads") {
+    atomic::bit_spinlock<uint32_t, 31> word;
+    int unsafe_value = 0;
+
+    const int NUM_THREADS = 100;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&word, &unsafe_value, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<atomic::bit_spinlock<uint32_t, 31> > guard(
+              word);
+
+          // Update both the unsafe value and the payload of the word (both are
+          // protected by the lock bit).
+          ++unsafe_value;
+          word.store(word.load(atomic::memory_order_relaxed) + 1u);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(unsafe_value == (NUM_THREADS * NUM_ITERATIONS));
+    CHECK(word.load() == static_cast<uint32_t>(NUM_THREADS * NUM_ITERATIONS));
+  }
 }
@@ -0,0 +1,80 @@
+#include "atomic/barrier.h"
+
+#include "doctest.h"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("spin_barrier multi threaded operation") {
+  SUBCASE("No thread passes a phase before all threads have arrived") {
+    const int NUM_THREADS = 8;
+    const int NUM_PHASES = 200;
+    atomic::spin_barrier barrier(NUM_THREADS);
+    atomic::atomic<int> arrived;
+    atomic::atomic<int> errors;
+    atomic::atomic<int> num_last;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread(
+          [&barrier, &arrived, &errors, &num_last, &NUM_PHASES]() {
+            for (int phase = 0; phase < NUM_PHASES; ++phase) {
+              ++arrived;
+              if (barrier.arrive_and_wait()) {
+                ++num_last;
+              }
+              if (arrived.load() < (phase + 1) * NUM_THREADS) {
+                ++errors;
+              }
+              barrier.arrive_and_wait();
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+    CHECK(num_last.load() == NUM_PHASES);
+  }
+}
+
+TEST_CASE("combining_tree_barrier multi threaded operation") {
+  SUBCASE("No thread passes a phase before all threads have arrived") {
+    const int NUM_THREADS = 11;
+    const int NUM_PHASES = 200;
+    atomic::combining_tree_barrier barrier(NUM_THREADS, 3);
+    atomic::atomic<int> arrived;
+    atomic::atomic<int> errors;
+    atomic::atomic<int> num_last;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread(
+          [&barrier, &arrived, &errors, &num_last, i, &NUM_PHASES]() {
+            for (int phase = 0; phase < NUM_PHASES; ++phase) {
+              ++arrived;
+              if (barrier.arrive_and_wait(i)) {
+                ++num_last;
+              }
+              if (arrived.load() < (phase + 1) * NUM_THREADS) {
+                ++errors;
+              }
+              barrier.arrive_and_wait(i);
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+    CHECK(num_last.load() == NUM_PHASES);
+  }
+
+  SUBCASE("A single thread never blocks") {
+    atomic::combining_tree_barrier barrier(1);
+    CHECK(barrier.arrive_and_wait(0) == true);
+    CHECK(barrier.arrive_and_wait(0) == true);
+  }
+}
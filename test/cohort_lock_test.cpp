@@ -0,0 +1,75 @@
+#include "atomic/cohort_lock.h"
+#include "atomic/spinlock.h"
+
+#include "doctest.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+// Simulated NUMA nodes: each test thread sets its own node.
+thread_local unsigned s_simulated_node = 0u;
+
+unsigned simulated_node() {
+  return s_simulated_node;
+}
+}  // namespace
+
+TEST_CASE("cohort_lock single threaded operation") {
+  SUBCASE("The lock can be taken repeatedly on the system nodes") {
+    atomic::cohort_lock lock;
+    for (int k = 0; k < 10; ++k) {
+      atomic::basic_lock_guard<atomic::cohort_lock> guard(lock);
+    }
+  }
+
+  SUBCASE("The lock can be taken from different simulated nodes") {
+    atomic::cohort_lock lock(4u, 3u, simulated_node);
+    for (unsigned node = 0u; node < 7u; ++node) {
+      s_simulated_node = node;
+      lock.lock();
+      lock.unlock();
+    }
+    s_simulated_node = 0u;
+  }
+}
+
+TEST_CASE("cohort_lock multi threaded operation") {
+  SUBCASE("Threads on two simulated nodes are mutually excluded") {
+    const int NUM_THREADS = 8;
+    const int NUM_ITERATIONS = 5000;
+    atomic::cohort_lock lock(16u, 2u, simulated_node);
+
+    // Protected by the lock.
+    int counter = 0;
+    std::vector<unsigned> nodes;
+    nodes.reserve(NUM_THREADS * NUM_ITERATIONS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&lock, &counter, &nodes, t] {
+        s_simulated_node = static_cast<unsigned>(t % 2);
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<atomic::cohort_lock> guard(lock);
+          ++counter;
+          nodes.push_back(s_simulated_node);
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(counter == NUM_THREADS * NUM_ITERATIONS);
+
+    // Handoff locality: most consecutive holders are on the same node.
+    std::size_t node_switches = 0u;
+    for (std::size_t i = 1u; i < nodes.size(); ++i) {
+      if (nodes[i] != nodes[i - 1u]) {
+        ++node_switches;
+      }
+    }
+    CHECK(node_switches * 4u < nodes.size());
+  }
+}
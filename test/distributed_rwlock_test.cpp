@@ -0,0 +1,88 @@
+#include "atomic/distributed_rwlock.h"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("distributed_rwlock single threaded operation") {
+  SUBCASE("Exclusive locking excludes all other locking") {
+    atomic::distributed_rwlock lock;
+    lock.lock();
+    CHECK(!lock.try_lock());
+    CHECK(!lock.try_lock_shared());
+    lock.unlock();
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+
+  SUBCASE("Shared locking excludes exclusive locking") {
+    atomic::distributed_rwlock lock;
+    lock.lock_shared();
+    CHECK(lock.try_lock_shared());
+    CHECK(!lock.try_lock());
+    lock.unlock_shared();
+    CHECK(!lock.try_lock());
+    lock.unlock_shared();
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+
+  SUBCASE("Lock guards release the lock") {
+    atomic::distributed_rwlock lock;
+    {
+      atomic::shared_lock_guard guard(lock);
+      CHECK(!lock.try_lock());
+    }
+    {
+      atomic::basic_lock_guard<atomic::distributed_rwlock> guard(lock);
+      CHECK(!lock.try_lock_shared());
+    }
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+}
+
+TEST_CASE("distributed_rwlock multi threaded operation") {
+  SUBCASE("Readers never see a partial update") {
+    const int NUM_READERS = 12;
+    const int NUM_WRITERS = 4;
+    const int NUM_READS = 20000;
+    const int NUM_WRITES = 500;
+    atomic::distributed_rwlock lock;
+
+    // Protected by the lock (the values are always equal outside of a write).
+    int64_t a = 0;
+    int64_t b = 0;
+    atomic::atomic<int> errors(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_READERS; ++t) {
+      threads.push_back(std::thread([&lock, &a, &b, &errors] {
+        for (int k = 0; k < NUM_READS; ++k) {
+          atomic::shared_lock_guard guard(lock);
+          if (a != b) {
+            errors.fetch_add(1);
+          }
+        }
+      }));
+    }
+    for (int t = 0; t < NUM_WRITERS; ++t) {
+      threads.push_back(std::thread([&lock, &a, &b] {
+        for (int k = 0; k < NUM_WRITES; ++k) {
+          atomic::basic_lock_guard<atomic::distributed_rwlock> guard(lock);
+          ++a;
+          ++b;
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(errors.load() == 0);
+    CHECK(a == NUM_WRITERS * NUM_WRITES);
+    CHECK(b == NUM_WRITERS * NUM_WRITES);
+  }
+}
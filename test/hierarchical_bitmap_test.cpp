@@ -0,0 +1,107 @@
+#include "atomic/hierarchical_bitmap.h"
+
+#include "doctest.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+const std::size_t NPOS = atomic::hierarchical_bitmap::npos;
+
+bool acquire_all_once(atomic::hierarchical_bitmap& bits) {
+  std::vector<int> seen(bits.size(), 0);
+  bool ok = true;
+  for (std::size_t i = 0; i < bits.size(); ++i) {
+    const std::size_t pos = bits.acquire_free();
+    ok = ok && (pos < bits.size()) && (++seen[pos] == 1);
+  }
+  return ok && (bits.acquire_free() == NPOS);
+}
+}  // namespace
+
+TEST_CASE("hierarchical_bitmap single threaded operation") {
+  SUBCASE("The number of levels grows logarithmically") {
+    CHECK(atomic::hierarchical_bitmap(1).num_levels() == 1u);
+    CHECK(atomic::hierarchical_bitmap(64).num_levels() == 1u);
+    CHECK(atomic::hierarchical_bitmap(65).num_levels() == 2u);
+    CHECK(atomic::hierarchical_bitmap(4096).num_levels() == 2u);
+    CHECK(atomic::hierarchical_bitmap(4097).num_levels() == 3u);
+  }
+
+  SUBCASE("test_and_set and reset return the old value") {
+    atomic::hierarchical_bitmap bits(1000);
+    CHECK(bits.test_and_set(700) == false);
+    CHECK(bits.test_and_set(700) == true);
+    CHECK(bits.test(700) == true);
+    CHECK(bits.count() == 1u);
+    CHECK(bits.reset(700) == true);
+    CHECK(bits.reset(700) == false);
+    CHECK(bits.count() == 0u);
+  }
+
+  SUBCASE("acquire_free hands out every bit exactly once") {
+    const std::size_t sizes[] = {1, 63, 64, 100, 4096, 5000, 300000};
+    for (int i = 0; i < 7; ++i) {
+      atomic::hierarchical_bitmap bits(sizes[i]);
+      CHECK(acquire_all_once(bits));
+      CHECK(bits.count() == sizes[i]);
+    }
+  }
+
+  SUBCASE("acquire_free finds the last free bit of a nearly full bitmap") {
+    atomic::hierarchical_bitmap bits(300000);
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+      bits.test_and_set(i);
+    }
+    CHECK(bits.acquire_free() == NPOS);
+    bits.reset(123456);
+    CHECK(bits.acquire_free() == 123456u);
+    CHECK(bits.acquire_free() == NPOS);
+  }
+}
+
+TEST_CASE("hierarchical_bitmap multi threaded operation") {
+  SUBCASE("Concurrent acquire and reset keep the summary consistent") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 5000;
+    const int NUM_LIVE = 8;
+    atomic::hierarchical_bitmap bits(NUM_THREADS * NUM_LIVE * 2);
+    atomic::atomic<int> errors;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(
+          std::thread([&bits, &errors, &NUM_ITERATIONS, &NUM_LIVE]() {
+            std::vector<std::size_t> live;
+            for (int k = 0; k < NUM_ITERATIONS; ++k) {
+              const std::size_t pos = bits.acquire_free();
+              if (pos == NPOS) {
+                ++errors;
+                continue;
+              }
+              live.push_back(pos);
+              if (live.size() == static_cast<std::size_t>(NUM_LIVE)) {
+                for (std::size_t j = 0; j < live.size(); ++j) {
+                  // A bit that was handed out twice is cleared twice.
+                  if (!bits.reset(live[j])) {
+                    ++errors;
+                  }
+                }
+                live.clear();
+              }
+            }
+            for (std::size_t j = 0; j < live.size(); ++j) {
+              bits.reset(live[j]);
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+    CHECK(bits.count() == 0u);
+    CHECK(acquire_all_once(bits));
+  }
+}
@@ -0,0 +1,97 @@
+#include "atomic/histogram.h"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("histogram single threaded operation") {
+  SUBCASE("An empty histogram has an empty snapshot") {
+    atomic::histogram hist;
+    const atomic::histogram_snapshot snap = hist.snapshot();
+    CHECK(snap.count() == 0u);
+    CHECK(snap.p50() == 0u);
+    CHECK(snap.min() == 0u);
+    CHECK(snap.max() == 0u);
+  }
+
+  SUBCASE("Small values are recorded exactly") {
+    atomic::histogram hist(5);
+    for (uint64_t v = 0; v < 32u; ++v) {
+      hist.record(v);
+    }
+    const atomic::histogram_snapshot snap = hist.snapshot();
+    CHECK(snap.count() == 32u);
+    CHECK(snap.min() == 0u);
+    CHECK(snap.max() == 31u);
+    CHECK(snap.p50() == 15u);
+  }
+
+  SUBCASE("Every value is within the bounds of its bucket") {
+    atomic::histogram hist(4);
+    const atomic::histogram_snapshot snap = hist.snapshot();
+    bool all_ok = true;
+    for (unsigned bit = 0; bit < 64u; ++bit) {
+      const uint64_t base = static_cast<uint64_t>(1) << bit;
+      const uint64_t values[] = {base, base + base / 3u, base + (base - 1u)};
+      for (int i = 0; i < 3; ++i) {
+        const std::size_t idx = hist.bucket_index(values[i]);
+        all_ok = all_ok && (idx < hist.num_buckets()) &&
+                 (snap.bucket_lower_bound(idx) <= values[i]) &&
+                 (values[i] <= snap.bucket_upper_bound(idx));
+      }
+    }
+    CHECK(all_ok);
+    CHECK(hist.bucket_index(~static_cast<uint64_t>(0)) ==
+          hist.num_buckets() - 1u);
+  }
+
+  SUBCASE("Percentiles are within the precision of the histogram") {
+    atomic::histogram hist(5);
+    for (uint64_t v = 1; v <= 100000u; ++v) {
+      hist.record(v);
+    }
+    const atomic::histogram_snapshot snap = hist.snapshot();
+    CHECK(snap.count() == 100000u);
+    CHECK(snap.p50() >= 50000u);
+    CHECK(snap.p50() <= 50000u + 50000u / 32u);
+    CHECK(snap.p99() >= 99000u);
+    CHECK(snap.p99() <= 99000u + 99000u / 32u);
+    CHECK(snap.p999() >= 99900u);
+    CHECK(snap.p999() <= 99900u + 99900u / 32u);
+  }
+
+  SUBCASE("reset clears all counts") {
+    atomic::histogram hist;
+    hist.record(1000u, 5u);
+    CHECK(hist.snapshot().count() == 5u);
+    hist.reset();
+    CHECK(hist.snapshot().count() == 0u);
+  }
+}
+
+TEST_CASE("histogram multi threaded operation") {
+  SUBCASE("Values recorded by 16 threads are all counted") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 10000;
+    atomic::histogram hist(5, 4);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&hist, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          hist.record(static_cast<uint64_t>(k % 1000));
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    const atomic::histogram_snapshot snap = hist.snapshot();
+    CHECK(snap.count() == static_cast<uint64_t>(NUM_THREADS * NUM_ITERATIONS));
+    CHECK(snap.min() == 0u);
+    CHECK(snap.max() >= 999u);
+  }
+}
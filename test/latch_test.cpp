@@ -0,0 +1,71 @@
+#include "atomic/latch.h"
+
+#include "doctest.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("latch single threaded operation") {
+  SUBCASE("try_wait succeeds once the counter reaches zero") {
+    atomic::latch latch(3);
+    CHECK(latch.try_wait() == false);
+    latch.count_down();
+    latch.count_down(2);
+    CHECK(latch.try_wait() == true);
+    latch.wait();
+  }
+}
+
+TEST_CASE("latch multi threaded operation") {
+  SUBCASE("wait blocks until all threads have counted down") {
+    const int NUM_THREADS = 16;
+    atomic::latch start(1);
+    atomic::latch done(NUM_THREADS);
+    atomic::atomic<int> counter;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&start, &done, &counter]() {
+        start.wait();
+        ++counter;
+        done.count_down();
+      }));
+    }
+
+    // Give the threads some time to block on the latch.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(counter.load() == 0);
+    start.count_down();
+    done.wait();
+    CHECK(counter.load() == NUM_THREADS);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+  }
+
+  SUBCASE("arrive_and_wait releases all threads together") {
+    const int NUM_THREADS = 8;
+    atomic::latch latch(NUM_THREADS);
+    atomic::atomic<int> arrived;
+    atomic::atomic<int> errors;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(
+          std::thread([&latch, &arrived, &errors, &NUM_THREADS]() {
+            ++arrived;
+            latch.arrive_and_wait();
+            if (arrived.load() != NUM_THREADS) {
+              ++errors;
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+  }
+}
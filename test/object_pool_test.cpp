@@ -0,0 +1,162 @@
+#include "atomic/object_pool.h"
+
+#include "doctest.h"
+
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+struct tracked {
+  static atomic::atomic<int> s_live;
+
+  explicit tracked(int v) : value(v) {
+    if (v < 0) {
+      throw std::runtime_error("negative");
+    }
+    ++s_live;
+  }
+  ~tracked() {
+    --s_live;
+  }
+
+  int value;
+};
+
+atomic::atomic<int> tracked::s_live;
+}  // namespace
+
+TEST_CASE("object_pool single threaded operation") {
+  SUBCASE("create constructs objects until the pool is empty") {
+    atomic::object_pool<tracked> pool(3);
+    CHECK(pool.capacity() == 3u);
+    tracked* a = pool.create(1);
+    tracked* b = pool.create(2);
+    tracked* c = pool.create(3);
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(c != nullptr);
+    CHECK(a != b);
+    CHECK(b != c);
+    CHECK(a->value + b->value + c->value == 6);
+    CHECK(pool.create(4) == nullptr);
+    CHECK(tracked::s_live.load() == 3);
+    pool.destroy(a);
+    pool.destroy(b);
+    pool.destroy(c);
+    CHECK(tracked::s_live.load() == 0);
+  }
+
+  SUBCASE("destroy makes the slot available again") {
+    atomic::object_pool<tracked> pool(1);
+    tracked* a = pool.create(1);
+    pool.destroy(a);
+    tracked* b = pool.create(2);
+    CHECK(b == a);
+    pool.destroy(b);
+  }
+
+  SUBCASE("A throwing constructor does not leak the slot") {
+    atomic::object_pool<tracked> pool(1);
+    CHECK_THROWS(pool.create(-1));
+    tracked* a = pool.create(1);
+    CHECK(a != nullptr);
+    pool.destroy(a);
+  }
+
+  SUBCASE("A capacity that does not fit a slot index is rejected") {
+    CHECK_THROWS_AS(
+        atomic::object_pool<int>(static_cast<std::size_t>(0xffffffffu)),
+        std::length_error);
+  }
+
+  SUBCASE("A magazine can use all slots of the pool") {
+    atomic::object_pool<tracked, 4> pool(10);
+    std::vector<tracked*> objects;
+    {
+      atomic::object_pool<tracked, 4>::magazine mag(pool);
+      for (int i = 0; i < 10; ++i) {
+        tracked* obj = mag.create(i);
+        REQUIRE(obj != nullptr);
+        objects.push_back(obj);
+      }
+      CHECK(mag.create(10) == nullptr);
+      for (size_t i = 0; i < objects.size(); ++i) {
+        mag.destroy(objects[i]);
+      }
+    }
+
+    // The magazine has been flushed, so all slots are back in the pool.
+    objects.clear();
+    for (int i = 0; i < 10; ++i) {
+      objects.push_back(pool.create(i));
+    }
+    CHECK(std::set<tracked*>(objects.begin(), objects.end()).size() == 10u);
+    CHECK(objects.back() != nullptr);
+    for (size_t i = 0; i < objects.size(); ++i) {
+      pool.destroy(objects[i]);
+    }
+    CHECK(tracked::s_live.load() == 0);
+  }
+}
+
+TEST_CASE("object_pool multi threaded operation") {
+  SUBCASE("Magazines in 16 threads never hand out an object twice") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 2000;
+    const int NUM_LIVE = 20;
+
+    // Each magazine may cache up to 8 free slots.
+    const int CAPACITY = NUM_THREADS * (NUM_LIVE + 8);
+    atomic::object_pool<int, 8> pool(CAPACITY);
+    atomic::atomic<int> errors;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread(
+          [&pool, &errors, i, &NUM_ITERATIONS, &NUM_LIVE]() {
+            atomic::object_pool<int, 8>::magazine mag(pool);
+            std::vector<int*> live;
+            for (int k = 0; k < NUM_ITERATIONS; ++k) {
+              int* obj = mag.create(i);
+              if (obj == nullptr) {
+                ++errors;
+                continue;
+              }
+              live.push_back(obj);
+              if (live.size() == static_cast<size_t>(NUM_LIVE)) {
+                for (size_t j = 0; j < live.size(); ++j) {
+                  // Another thread would have overwritten the value if the
+                  // object had been handed out twice.
+                  if (*live[j] != i) {
+                    ++errors;
+                  }
+                  mag.destroy(live[j]);
+                }
+                live.clear();
+              }
+            }
+            for (size_t j = 0; j < live.size(); ++j) {
+              mag.destroy(live[j]);
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+
+    // All the slots must be back in the pool.
+    std::vector<int*> objects;
+    for (int i = 0; i < CAPACITY; ++i) {
+      objects.push_back(pool.create(i));
+    }
+    CHECK(objects.back() != nullptr);
+    CHECK(pool.create(0) == nullptr);
+    for (size_t i = 0; i < objects.size(); ++i) {
+      pool.destroy(objects[i]);
+    }
+  }
+}
@@ -0,0 +1,244 @@
+#include "atomic/parking_lot.h"
+
+#include "doctest.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+typedef atomic::parking_lot::park_result park_result;
+typedef atomic::parking_lot::unpark_result unpark_result;
+
+// A one-byte mutex that keeps its waiting threads in the parking lot.
+class byte_mutex {
+public:
+  byte_mutex() : state_(0) {}
+
+  void lock() {
+    uint8_t state = 0;
+    if (state_.compare_exchange_weak(state, LOCKED)) {
+      return;
+    }
+    for (;;) {
+      state = state_.load();
+      if ((state & LOCKED) == 0) {
+        if (state_.compare_exchange_weak(state, state | LOCKED)) {
+          return;
+        }
+        continue;
+      }
+      if ((state & PARKED) == 0 &&
+          !state_.compare_exchange_weak(state, state | PARKED)) {
+        continue;
+      }
+      atomic::parking_lot::park(
+          &state_, [this] { return state_.load() == (LOCKED | PARKED); });
+    }
+  }
+
+  void unlock() {
+    uint8_t state = LOCKED;
+    if (state_.compare_exchange_weak(state, 0)) {
+      return;
+    }
+    atomic::parking_lot::unpark_one(&state_, [this](const unpark_result& r) {
+      state_.store(r.have_more_threads ? PARKED : 0);
+    });
+  }
+
+private:
+  static const uint8_t LOCKED = 1u;
+  static const uint8_t PARKED = 2u;
+
+  atomic::atomic<uint8_t> state_;
+};
+
+// Unpark one thread that is parked on an address, waiting for it to park.
+void unpark_one_eventually(const void* address) {
+  while (!atomic::parking_lot::unpark_one(address)) {
+    std::this_thread::yield();
+  }
+}
+}  // namespace
+
+TEST_CASE("parking_lot single threaded operation") {
+  SUBCASE("A failed validation does not park") {
+    int word = 0;
+    const park_result result =
+        atomic::parking_lot::park(&word, [] { return false; });
+    CHECK(result == park_result::invalid);
+  }
+
+  SUBCASE("Parking times out") {
+    int word = 0;
+    const park_result result = atomic::parking_lot::park(
+        &word, [] { return true; }, std::chrono::milliseconds(10));
+    CHECK(result == park_result::timed_out);
+
+    // The timed out thread is no longer parked.
+    CHECK(!atomic::parking_lot::unpark_one(&word));
+  }
+
+  SUBCASE("Unparking an address without parked threads does nothing") {
+    int word = 0;
+    bool called = false;
+    atomic::parking_lot::unpark_one(&word, [&called](const unpark_result& r) {
+      called = true;
+      CHECK(!r.did_unpark_thread);
+      CHECK(!r.have_more_threads);
+    });
+    CHECK(called);
+    CHECK(atomic::parking_lot::unpark_all(&word) == 0u);
+  }
+}
+
+TEST_CASE("parking_lot multi threaded operation") {
+  SUBCASE("A parked thread is unparked") {
+    atomic::atomic<int> word(0);
+    park_result result = park_result::invalid;
+    std::thread waiter([&word, &result] {
+      result = atomic::parking_lot::park(&word,
+                                         [&word] { return word.load() == 0; });
+    });
+    unpark_one_eventually(&word);
+    waiter.join();
+    CHECK(result == park_result::unparked);
+  }
+
+  SUBCASE("Threads are unparked in FIFO order") {
+    const int NUM_THREADS = 3;
+    int word = 0;
+    atomic::atomic<int> num_parked(0);
+    atomic::atomic<int> last_unparked(-1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&word, &num_parked, &last_unparked, t] {
+        (void)atomic::parking_lot::park(&word, [&num_parked] {
+          num_parked.fetch_add(1);
+          return true;
+        });
+        last_unparked.store(t);
+      }));
+
+      // Start the next thread once this one is parked.
+      while (num_parked.load() == t) {
+        std::this_thread::yield();
+      }
+    }
+
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      unpark_result result = {false, false};
+      atomic::parking_lot::unpark_one(
+          &word, [&result](const unpark_result& r) { result = r; });
+      CHECK(result.did_unpark_thread);
+      CHECK(result.have_more_threads == (t < NUM_THREADS - 1));
+      while (last_unparked.load() != t) {
+        std::this_thread::yield();
+      }
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  SUBCASE("unpark_all unparks all threads parked on the address") {
+    const int NUM_THREADS = 8;
+    int word = 0;
+    int other_word = 0;
+    atomic::atomic<int> num_parked(0);
+    atomic::atomic<int> num_unparked(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&word, &num_parked, &num_unparked] {
+        const park_result result = atomic::parking_lot::park(
+            &word, [&num_parked] {
+              num_parked.fetch_add(1);
+              return true;
+            });
+        if (result == park_result::unparked) {
+          num_unparked.fetch_add(1);
+        }
+      }));
+    }
+
+    // A thread parked on another address is not affected.
+    std::thread other([&other_word] {
+      (void)atomic::parking_lot::park(&other_word, [] { return true; });
+    });
+
+    while (num_parked.load() < NUM_THREADS) {
+      std::this_thread::yield();
+    }
+    CHECK(atomic::parking_lot::unpark_all(&word) ==
+          static_cast<std::size_t>(NUM_THREADS));
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    CHECK(num_unparked.load() == NUM_THREADS);
+
+    unpark_one_eventually(&other_word);
+    other.join();
+  }
+
+  SUBCASE("Timeouts race with unparks") {
+    const int NUM_THREADS = 4;
+    const int NUM_ITERATIONS = 200;
+    int word = 0;
+    atomic::atomic<int> done(0);
+    atomic::atomic<int> num_results(0);
+
+    std::thread unparker([&word, &done] {
+      while (done.load() == 0) {
+        (void)atomic::parking_lot::unpark_all(&word);
+        std::this_thread::yield();
+      }
+    });
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&word, &num_results] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          const park_result result = atomic::parking_lot::park(
+              &word, [] { return true; }, std::chrono::microseconds(50));
+          if (result == park_result::unparked ||
+              result == park_result::timed_out) {
+            num_results.fetch_add(1);
+          }
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    done.store(1);
+    unparker.join();
+
+    CHECK(num_results.load() == NUM_THREADS * NUM_ITERATIONS);
+    CHECK(!atomic::parking_lot::unpark_one(&word));
+  }
+
+  SUBCASE("A one-byte mutex built on the parking lot") {
+    const int NUM_THREADS = 8;
+    const int NUM_ITERATIONS = 5000;
+    byte_mutex lock;
+
+    // Protected by the lock.
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&lock, &counter] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<byte_mutex> guard(lock);
+          ++counter;
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(counter == NUM_THREADS * NUM_ITERATIONS);
+  }
+}
@@ -0,0 +1,126 @@
+#include "atomic/percpu_counter.h"
+
+#include "doctest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST_CASE("percpu_counter single threaded operation") {
+  SUBCASE("A new counter is zero") {
+    atomic::percpu_counter<int64_t> counter;
+    CHECK(counter.sum() == 0);
+  }
+
+  SUBCASE("add and sub update the sum") {
+    atomic::percpu_counter<int64_t> counter;
+    counter.add(5);
+    counter.add(10);
+    counter.sub(3);
+    CHECK(counter.sum() == 12);
+    counter.sub(20);
+    CHECK(counter.sum() == -8);
+  }
+
+  SUBCASE("Small and unsigned types wrap around") {
+    atomic::percpu_counter<uint8_t> counter;
+    counter.add(200u);
+    counter.add(100u);
+    CHECK(counter.sum() == static_cast<uint8_t>(44u));
+    counter.sub(50u);
+    CHECK(counter.sum() == static_cast<uint8_t>(250u));
+  }
+
+  SUBCASE("reset clears the counter") {
+    atomic::percpu_counter<uint32_t> counter;
+    counter.add(42u);
+    counter.reset();
+    CHECK(counter.sum() == 0u);
+    counter.add(1u);
+    CHECK(counter.sum() == 1u);
+  }
+}
+
+namespace {
+atomic::percpu_counter<int>* g_exit_counter = nullptr;
+
+// Adds to g_exit_counter when a thread exits.
+struct add_at_thread_exit {
+  ~add_at_thread_exit() {
+    g_exit_counter->add(1);
+  }
+};
+}  // namespace
+
+TEST_CASE("percpu_counter multi threaded operation") {
+  SUBCASE("add works in thread_local destructors") {
+    // Note: The guard is constructed before the first add(), so it is
+    // destroyed after any rseq registration of the thread.
+    atomic::percpu_counter<int> counter;
+    g_exit_counter = &counter;
+    std::thread thread([&counter] {
+      static thread_local add_at_thread_exit s_guard;
+      (void)s_guard;
+      counter.add(1);
+    });
+    thread.join();
+    CHECK(counter.sum() == 2);
+    g_exit_counter = nullptr;
+  }
+
+  SUBCASE("Increments from 16 threads are all counted") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 100000;
+    atomic::percpu_counter<uint64_t> counter;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&counter] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          counter.add(1u);
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(counter.sum() ==
+          static_cast<uint64_t>(NUM_THREADS) * NUM_ITERATIONS);
+  }
+
+  SUBCASE("Concurrent readers see a monotonic sum") {
+    const int NUM_THREADS = 4;
+    const int NUM_ITERATIONS = 50000;
+    atomic::percpu_counter<uint64_t> counter;
+    atomic::atomic<int> done(0);
+    bool monotonic = true;
+
+    std::thread reader([&counter, &done, &monotonic] {
+      uint64_t last = 0u;
+      while (done.load() == 0) {
+        const uint64_t current = counter.sum();
+        monotonic = monotonic && (current >= last);
+        last = current;
+      }
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&counter] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          counter.add(1u);
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    done.store(1);
+    reader.join();
+
+    CHECK(monotonic);
+    CHECK(counter.sum() ==
+          static_cast<uint64_t>(NUM_THREADS) * NUM_ITERATIONS);
+  }
+}
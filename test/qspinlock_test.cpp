@@ -0,0 +1,152 @@
+#include "atomic/qspinlock.h"
+#include "atomic/spinlock.h"
+
+#include "doctest.h"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("qspinlock single threaded operation") {
+  SUBCASE("The lock is as small as a spinlock") {
+    CHECK(sizeof(atomic::qspinlock) == sizeof(atomic::spinlock));
+  }
+
+  SUBCASE("try_lock fails while the lock is held") {
+    atomic::qspinlock lock;
+    CHECK(lock.try_lock());
+    CHECK(!lock.try_lock());
+    lock.unlock();
+    CHECK(lock.try_lock());
+    lock.unlock();
+  }
+
+  SUBCASE("Many locks can be held at the same time") {
+    atomic::qspinlock locks[16];
+    for (int i = 0; i < 16; ++i) {
+      locks[i].lock();
+    }
+    for (int i = 0; i < 16; ++i) {
+      CHECK(!locks[i].try_lock());
+      locks[i].unlock();
+    }
+  }
+}
+
+TEST_CASE("qspinlock multi threaded operation") {
+  SUBCASE("Increments from 16 threads are mutually excluded") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 5000;
+    atomic::qspinlock lock;
+
+    // Protected by the lock.
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&lock, &counter] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::basic_lock_guard<atomic::qspinlock> guard(lock);
+          ++counter;
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(counter == NUM_THREADS * NUM_ITERATIONS);
+  }
+
+  SUBCASE("Threads that take turns on several locks are mutually excluded") {
+    const int NUM_THREADS = 8;
+    const int NUM_LOCKS = 4;
+    const int NUM_ITERATIONS = 5000;
+    atomic::qspinlock locks[NUM_LOCKS];
+    int counters[NUM_LOCKS] = {0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&locks, &counters, t] {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          const int i = (t + k) % NUM_LOCKS;
+          atomic::basic_lock_guard<atomic::qspinlock> guard(locks[i]);
+          ++counters[i];
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    int total = 0;
+    for (int i = 0; i < NUM_LOCKS; ++i) {
+      total += counters[i];
+    }
+    CHECK(total == NUM_THREADS * NUM_ITERATIONS);
+  }
+
+  SUBCASE("Threads without queue nodes can contend with queued threads") {
+    const int NUM_THREADS = 4;
+    const int NUM_ITERATIONS = 5000;
+    atomic::qspinlock lock;
+    atomic::detail::qnode_registry& registry =
+        atomic::detail::qnode_registry::instance();
+
+    // Protected by the lock.
+    int counter = 0;
+
+    auto work = [&lock, &counter] {
+      for (int k = 0; k < NUM_ITERATIONS; ++k) {
+        atomic::basic_lock_guard<atomic::qspinlock> guard(lock);
+        ++counter;
+      }
+    };
+
+    // Threads that get a thread id (and thus queue nodes) before the ids run
+    // out.
+    atomic::atomic<int> num_registered(0);
+    atomic::atomic<int> start(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&num_registered, &start, &work] {
+        (void)atomic::detail::qnode_thread_id();
+        num_registered.fetch_add(1);
+        while (start.load() == 0) {
+          std::this_thread::yield();
+        }
+        work();
+      }));
+    }
+    while (num_registered.load() < NUM_THREADS) {
+      std::this_thread::yield();
+    }
+
+    // Use up the remaining ids, so that new threads get no queue nodes.
+    std::vector<unsigned> ids;
+    for (;;) {
+      const unsigned id = registry.acquire_id();
+      if (id == atomic::detail::qnode_registry::INVALID_ID) {
+        break;
+      }
+      ids.push_back(id);
+    }
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      threads.push_back(std::thread([&start, &work] {
+        while (start.load() == 0) {
+          std::this_thread::yield();
+        }
+        work();
+      }));
+    }
+
+    start.store(1);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const unsigned id : ids) {
+      registry.release_id(id);
+    }
+
+    CHECK(counter == 2 * NUM_THREADS * NUM_ITERATIONS);
+  }
+}
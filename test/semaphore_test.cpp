@@ -0,0 +1,140 @@
+#include "atomic/semaphore.h"
+
+#include "doctest.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST_CASE("semaphore single threaded operation") {
+  SUBCASE("try_acquire succeeds while the count is positive") {
+    atomic::semaphore sem(2);
+    CHECK(sem.try_acquire() == true);
+    CHECK(sem.try_acquire() == true);
+    CHECK(sem.try_acquire() == false);
+    sem.release();
+    CHECK(sem.try_acquire() == true);
+  }
+
+  SUBCASE("acquire does not block while the count is positive") {
+    atomic::semaphore sem(1);
+    sem.acquire();
+    CHECK(sem.try_acquire() == false);
+  }
+
+  SUBCASE("try_acquire_for times out and restores the count") {
+    atomic::semaphore sem(0);
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    CHECK(sem.try_acquire_for(std::chrono::milliseconds(20)) == false);
+    CHECK(std::chrono::steady_clock::now() - start >=
+          std::chrono::milliseconds(20));
+    sem.release();
+    CHECK(sem.try_acquire() == true);
+    CHECK(sem.try_acquire() == false);
+  }
+
+  SUBCASE("binary_semaphore toggles between available and unavailable") {
+    atomic::binary_semaphore sem(true);
+    CHECK(sem.try_acquire() == true);
+    CHECK(sem.try_acquire() == false);
+    CHECK(sem.try_acquire_for(std::chrono::milliseconds(1)) == false);
+    sem.release();
+    sem.acquire();
+    CHECK(sem.try_acquire() == false);
+  }
+}
+
+TEST_CASE("semaphore multi threaded operation") {
+  SUBCASE("The semaphore limits the number of concurrent holders") {
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 500;
+    const int MAX_HOLDERS = 3;
+    atomic::semaphore sem(MAX_HOLDERS);
+    atomic::atomic<int> holders;
+    atomic::atomic<int> errors;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread(
+          [&sem, &holders, &errors, &NUM_ITERATIONS, &MAX_HOLDERS]() {
+            for (int k = 0; k < NUM_ITERATIONS; ++k) {
+              sem.acquire();
+              if (++holders > MAX_HOLDERS) {
+                ++errors;
+              }
+              --holders;
+              sem.release();
+            }
+          }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(errors.load() == 0);
+    for (int i = 0; i < MAX_HOLDERS; ++i) {
+      CHECK(sem.try_acquire() == true);
+    }
+    CHECK(sem.try_acquire() == false);
+  }
+
+  SUBCASE("release(n) wakes exactly n waiters") {
+    const int NUM_THREADS = 8;
+    atomic::semaphore sem(0);
+    atomic::atomic<int> acquired;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&sem, &acquired]() {
+        sem.acquire();
+        ++acquired;
+      }));
+    }
+
+    sem.release(3);
+    while (acquired.load() < 3) {
+      std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(acquired.load() == 3);
+
+    sem.release(NUM_THREADS - 3);
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+    CHECK(acquired.load() == NUM_THREADS);
+    CHECK(sem.try_acquire() == false);
+  }
+
+  SUBCASE("Timed out waiters do not swallow releases") {
+    const int NUM_THREADS = 8;
+    const int NUM_ITERATIONS = 200;
+    atomic::semaphore sem(0);
+    atomic::atomic<int> acquired;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&sem, &acquired, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          if (sem.try_acquire_for(std::chrono::microseconds(50))) {
+            ++acquired;
+          }
+        }
+      }));
+    }
+    for (int k = 0; k < NUM_ITERATIONS; ++k) {
+      sem.release();
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    // Every release has either been acquired, or is still available.
+    int remaining = 0;
+    while (sem.try_acquire()) {
+      ++remaining;
+    }
+    CHECK(acquired.load() + remaining == NUM_ITERATIONS);
+  }
+}
@@ -0,0 +1,104 @@
+#include "atomic/spinlock.h"
+
+#include "doctest.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+const atomic::spinlock_stats* find_stats(
+    const std::vector<atomic::spinlock_stats>& stats,
+    const atomic::spinlock& lock) {
+  for (size_t i = 0; i < stats.size(); ++i) {
+    if (stats[i].address == &lock) {
+      return &stats[i];
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+TEST_CASE("spinlock stats single threaded operation") {
+  SUBCASE("Uncontended acquisitions are counted") {
+    atomic::spinlock lock("uncontended");
+    for (int i = 0; i < 10; ++i) {
+      atomic::lock_guard guard(lock);
+    }
+    const atomic::spinlock_stats stats = lock.stats();
+    CHECK(std::string(stats.name) == "uncontended");
+    CHECK(stats.acquisitions == 10u);
+    CHECK(stats.contended_acquisitions == 0u);
+    CHECK(stats.spin_iterations == 0u);
+    CHECK(stats.max_wait_cycles == 0u);
+  }
+
+  SUBCASE("Live locks are registered, and destroyed locks are not") {
+    atomic::spinlock lock1;
+    const atomic::spinlock* address2 = nullptr;
+    {
+      atomic::spinlock lock2;
+      address2 = &lock2;
+      const std::vector<atomic::spinlock_stats> stats =
+          atomic::get_spinlock_stats();
+      CHECK(find_stats(stats, lock1) != nullptr);
+      CHECK(find_stats(stats, lock2) != nullptr);
+    }
+    const std::vector<atomic::spinlock_stats> stats =
+        atomic::get_spinlock_stats();
+    CHECK(find_stats(stats, lock1) != nullptr);
+    bool found2 = false;
+    for (size_t i = 0; i < stats.size(); ++i) {
+      found2 = found2 || (stats[i].address == address2);
+    }
+    CHECK(found2 == false);
+  }
+}
+
+TEST_CASE("spinlock stats multi threaded operation") {
+  SUBCASE("Contention is recorded and reported") {
+    atomic::spinlock hot_lock("hot");
+    atomic::spinlock cold_lock("cold");
+
+    const int NUM_THREADS = 8;
+    const int NUM_ITERATIONS = 2000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&hot_lock, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          atomic::lock_guard guard(hot_lock);
+          if ((k % 100) == 0) {
+            // Hold the lock long enough for the other threads to notice.
+            std::this_thread::yield();
+          }
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+    cold_lock.lock();
+    cold_lock.unlock();
+
+    const atomic::spinlock_stats hot = hot_lock.stats();
+    CHECK(hot.acquisitions ==
+          static_cast<uint64_t>(NUM_THREADS * NUM_ITERATIONS));
+    CHECK(hot.contended_acquisitions > 0u);
+    CHECK(hot.spin_iterations >= hot.contended_acquisitions);
+    CHECK(hot.max_wait_cycles > 0u);
+
+    // The most contended lock is reported first.
+    const std::vector<atomic::spinlock_stats> stats =
+        atomic::get_spinlock_stats();
+    REQUIRE(stats.size() >= 2u);
+    CHECK(stats[0].address == &hot_lock);
+
+    std::ostringstream report;
+    atomic::dump_spinlock_stats(report);
+    const std::string text = report.str();
+    CHECK(text.find("hot") != std::string::npos);
+    CHECK(text.find("cold") != std::string::npos);
+    CHECK(text.find("hot") < text.find("cold"));
+  }
+}
@@ -0,0 +1,153 @@
+#include "atomic/striped_hash_map.h"
+
+#include "doctest.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("striped_hash_map single threaded operation") {
+  SUBCASE("A new map is empty") {
+    atomic::striped_hash_map<int, int> map;
+    CHECK(map.size() == 0u);
+    CHECK(map.contains(42) == false);
+  }
+
+  SUBCASE("The number of stripes is rounded up to a power of two") {
+    atomic::striped_hash_map<int, int> map(5);
+    CHECK(map.num_stripes() == 8u);
+  }
+
+  SUBCASE("insert adds new keys but does not replace existing keys") {
+    atomic::striped_hash_map<std::string, int> map;
+    CHECK(map.insert("foo", 1) == true);
+    CHECK(map.insert("foo", 2) == false);
+    int value = 0;
+    CHECK(map.find("foo", value) == true);
+    CHECK(value == 1);
+    CHECK(map.size() == 1u);
+  }
+
+  SUBCASE("insert_or_assign replaces existing keys") {
+    atomic::striped_hash_map<std::string, int> map;
+    CHECK(map.insert_or_assign("foo", 1) == true);
+    CHECK(map.insert_or_assign("foo", 2) == false);
+    int value = 0;
+    CHECK(map.find("foo", value) == true);
+    CHECK(value == 2);
+    CHECK(map.size() == 1u);
+  }
+
+  SUBCASE("erase removes keys") {
+    atomic::striped_hash_map<int, int> map;
+    map.insert(1, 10);
+    map.insert(2, 20);
+    CHECK(map.erase(1) == true);
+    CHECK(map.erase(1) == false);
+    CHECK(map.contains(1) == false);
+    CHECK(map.contains(2) == true);
+    CHECK(map.size() == 1u);
+  }
+
+  SUBCASE("update modifies values in place") {
+    atomic::striped_hash_map<int, int> map;
+    map.insert(1, 10);
+    CHECK(map.update(1, [](int& v) { v += 5; }) == true);
+    CHECK(map.update(2, [](int& v) { v += 5; }) == false);
+    int value = 0;
+    map.find(1, value);
+    CHECK(value == 15);
+  }
+
+  SUBCASE("Move-only values are supported") {
+    atomic::striped_hash_map<int, std::unique_ptr<int> > map(2, 2);
+    for (int i = 0; i < 100; ++i) {
+      map.insert(i, std::unique_ptr<int>(new int(i)));
+    }
+    int sum = 0;
+    for (int i = 0; i < 100; ++i) {
+      map.update(i, [&sum](std::unique_ptr<int>& p) { sum += *p; });
+    }
+    CHECK(sum == 4950);
+  }
+
+  SUBCASE("Keys survive growing the map") {
+    atomic::striped_hash_map<int, int> map(4, 4);
+    for (int i = 0; i < 1000; ++i) {
+      map.insert(i, i * 2);
+    }
+    CHECK(map.size() == 1000u);
+    bool all_found = true;
+    for (int i = 0; i < 1000; ++i) {
+      int value = -1;
+      all_found = all_found && map.find(i, value) && (value == i * 2);
+    }
+    CHECK(all_found);
+  }
+
+  SUBCASE("clear removes all keys") {
+    atomic::striped_hash_map<int, int> map;
+    for (int i = 0; i < 100; ++i) {
+      map.insert(i, i);
+    }
+    map.clear();
+    CHECK(map.size() == 0u);
+    CHECK(map.contains(50) == false);
+  }
+}
+
+TEST_CASE("striped_hash_map multi threaded operation") {
+  SUBCASE("Concurrent inserts and erases from 16 threads") {
+    atomic::striped_hash_map<int, int> map(8, 8);
+
+    const int NUM_THREADS = 16;
+    const int NUM_KEYS = 2000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&map, i, &NUM_KEYS]() {
+        // Each thread inserts its own keys, and erases every other key.
+        const int first_key = i * NUM_KEYS;
+        for (int k = 0; k < NUM_KEYS; ++k) {
+          map.insert(first_key + k, k);
+        }
+        for (int k = 0; k < NUM_KEYS; k += 2) {
+          map.erase(first_key + k);
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    CHECK(map.size() == static_cast<std::size_t>(NUM_THREADS * NUM_KEYS / 2));
+    bool all_ok = true;
+    for (int key = 0; key < NUM_THREADS * NUM_KEYS; ++key) {
+      all_ok = all_ok && (map.contains(key) == ((key % 2) != 0));
+    }
+    CHECK(all_ok);
+  }
+
+  SUBCASE("Concurrent updates of a shared key from 16 threads") {
+    atomic::striped_hash_map<int, int> map;
+    map.insert(7, 0);
+
+    const int NUM_THREADS = 16;
+    const int NUM_ITERATIONS = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads.push_back(std::thread([&map, &NUM_ITERATIONS]() {
+        for (int k = 0; k < NUM_ITERATIONS; ++k) {
+          map.update(7, [](int& v) { ++v; });
+        }
+      }));
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+      threads[i].join();
+    }
+
+    int value = 0;
+    map.find(7, value);
+    CHECK(value == NUM_THREADS * NUM_ITERATIONS);
+  }
+}